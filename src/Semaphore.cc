@@ -22,3 +22,24 @@ void Semaphore::wait()
                     { return count_ > 0; }); // esperar mientras count_ sea 0
     count_--;
 }
+
+// Igual que wait() pero se rinde despues de timeout
+bool Semaphore::waitFor(chrono::microseconds timeout)
+{
+    lock_guard<mutex> lg(mutex_);
+    if (!condition_.wait_for(mutex_, timeout, [this]()
+                             { return count_ > 0; }))
+        return false;
+    count_--;
+    return true;
+}
+
+// Toma el semaforo solo si ya esta disponible
+bool Semaphore::tryWait()
+{
+    lock_guard<mutex> lg(mutex_);
+    if (count_ == 0)
+        return false;
+    count_--;
+    return true;
+}
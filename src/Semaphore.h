@@ -3,6 +3,7 @@
 
 #include <condition_variable>
 #include <mutex>
+#include <chrono>
 
 using namespace std;
 
@@ -12,6 +13,8 @@ public:
     Semaphore(int count = 0);
     void signal(); // liberar
     void wait();   // esperar
+    bool waitFor(chrono::microseconds timeout); // esperar con timeout, false si vencio
+    bool tryWait(); // sin bloquear, false si no habia
 
 private:
     int count_;
@@ -0,0 +1,78 @@
+#include "arena.h"
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+using namespace std;
+
+Arena::Arena(size_t chunkSize) : chunkSize(chunkSize),
+                                 current(0),
+                                 previous(0),
+                                 ptr(nullptr),
+                                 end(nullptr)
+{
+    if (chunkSize == 0)
+    {
+        throw invalid_argument("Arena chunk size must be positive");
+    }
+}
+
+void *Arena::allocate(size_t bytes, size_t align)
+{
+    uintptr_t p = (reinterpret_cast<uintptr_t>(ptr) + align - 1) & ~(uintptr_t)(align - 1);
+    if (!ptr || p + bytes > reinterpret_cast<uintptr_t>(end))
+    {
+        if (!nextChunk(bytes, align))
+            throw bad_alloc();
+        p = (reinterpret_cast<uintptr_t>(ptr) + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    ptr = reinterpret_cast<char *>(p + bytes);
+    return reinterpret_cast<void *>(p);
+}
+
+// Pasa al proximo chunk donde entre el pedido, o agrega uno nuevo
+bool Arena::nextChunk(size_t bytes, size_t align)
+{
+    size_t need = bytes + align;
+    size_t next = ptr ? current + 1 : current;
+    if (ptr)
+        previous += ptr - chunks[current].data;
+
+    while (next < chunks.size() && chunks[next].size < need)
+        next++; // los que no alcanzan se saltean hasta el proximo reset
+
+    if (next == chunks.size())
+    {
+        // Cada chunk nuevo al menos el doble del anterior, pa' pocos mallocs
+        size_t size = chunks.empty() ? chunkSize : chunks.back().size * 2;
+        if (size < need)
+            size = need;
+        char *data = static_cast<char *>(::operator new(size, nothrow));
+        if (!data)
+            return false;
+        chunks.push_back(chunk_t{data, size});
+    }
+
+    current = next;
+    ptr = chunks[current].data;
+    end = ptr + chunks[current].size;
+    return true;
+}
+
+void Arena::reset()
+{
+    current = 0;
+    previous = 0;
+    ptr = chunks.empty() ? nullptr : chunks[0].data;
+    end = chunks.empty() ? nullptr : chunks[0].data + chunks[0].size;
+}
+
+size_t Arena::used() const
+{
+    return ptr ? previous + (ptr - chunks[current].data) : 0;
+}
+
+Arena::~Arena()
+{
+    for (auto &c : chunks)
+        ::operator delete(c.data);
+}
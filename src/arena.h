@@ -0,0 +1,72 @@
+#ifndef _arena_
+#define _arena_
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Arena bump-pointer: pedir memoria es correr un puntero y no hay free,
+// se suelta todo junto con reset(). Los chunks se reusan entre resets y se
+// piden recien la primera vez que hacen falta (desde el hilo que la usa,
+// asi la memoria queda en el nodo NUMA de ese hilo). No es thread-safe.
+class Arena
+{
+public:
+  Arena(size_t chunkSize = 64 * 1024);
+
+  // Memoria sin inicializar alineada a align (potencia de 2)
+  void *allocate(size_t bytes, size_t align = alignof(max_align_t));
+
+  // Todo lo entregado queda invalido; los chunks se quedan pa' la proxima
+  void reset();
+
+  // Bytes entregados desde el ultimo reset (contando el padding)
+  size_t used() const;
+
+  ~Arena();
+
+private:
+  typedef struct chunk
+  {
+    char *data;
+    size_t size;
+  } chunk_t;
+
+  bool nextChunk(size_t bytes, size_t align);
+
+  size_t chunkSize;
+  vector<chunk_t> chunks;
+  size_t current;  // chunk donde estamos cortando
+  size_t previous; // bytes usados en los chunks anteriores a current
+  char *ptr;
+  char *end;
+
+  Arena(const Arena &original) = delete;
+  Arena &operator=(const Arena &rhs) = delete;
+};
+
+// Adaptador pa' contenedores STL: vector<int, ArenaAllocator<int>> v(arena).
+// deallocate no hace nada, la memoria vuelve con el reset de la arena
+template <typename T>
+struct ArenaAllocator
+{
+  typedef T value_type;
+
+  Arena *arena;
+
+  ArenaAllocator(Arena &arena) : arena(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T *, size_t) {}
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.arena == b.arena; }
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.arena != b.arena; }
+
+#endif
@@ -0,0 +1,132 @@
+#include "thread-pool.h"
+#include "parallel-sort.h"
+#include "parallel-scan.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <numeric>
+#include <atomic>
+
+using namespace std;
+using namespace chrono;
+
+// Benchmarks de los algoritmos paralelos contra su version secuencial.
+// Uso: ./bench [maxElementos]   (default 100M, va de 1M en x10)
+
+static vector<uint32_t> randomInput(size_t n)
+{
+    vector<uint32_t> data(n);
+    uint32_t x = 2463534242u;
+    for (auto &v : data)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        v = x;
+    }
+    return data;
+}
+
+template <typename F>
+static double timeMs(F f)
+{
+    auto t0 = high_resolution_clock::now();
+    f();
+    auto t1 = high_resolution_clock::now();
+    return duration_cast<microseconds>(t1 - t0).count() / 1000.0;
+}
+
+static void benchSort(size_t maxN)
+{
+    cout << "parallel_sort vs std::sort (ms)" << endl;
+    cout << setw(12) << "n" << setw(12) << "std::sort";
+    vector<size_t> threadCounts = {1, 2, 4, 8, 16};
+    for (size_t t : threadCounts)
+        cout << setw(10) << ("p=" + to_string(t));
+    cout << endl;
+
+    for (size_t n = 1000000; n <= maxN; n *= 10)
+    {
+        vector<uint32_t> input = randomInput(n);
+        vector<uint32_t> data = input;
+        cout << setw(12) << n << setw(12) << fixed << setprecision(1)
+             << timeMs([&]()
+                       { sort(data.begin(), data.end()); });
+
+        for (size_t t : threadCounts)
+        {
+            ThreadPool pool(t);
+            data = input;
+            cout << setw(10) << timeMs([&]()
+                                       { parallel_sort(pool, data.begin(), data.end()); });
+        }
+        cout << endl;
+    }
+}
+
+static void benchScan(size_t maxN)
+{
+    cout << "parallel_inclusive_scan vs std::inclusive_scan (ms)" << endl;
+    cout << setw(12) << "n" << setw(12) << "sequential";
+    vector<size_t> threadCounts = {1, 2, 4, 8, 16};
+    for (size_t t : threadCounts)
+        cout << setw(10) << ("p=" + to_string(t));
+    cout << endl;
+
+    for (size_t n = 1000000; n <= maxN; n *= 10)
+    {
+        vector<uint32_t> input = randomInput(n);
+        vector<uint64_t> output(n);
+        cout << setw(12) << n << setw(12) << fixed << setprecision(1)
+             << timeMs([&]()
+                       { inclusive_scan(input.begin(), input.end(), output.begin(), plus<uint64_t>()); });
+
+        for (size_t t : threadCounts)
+        {
+            ThreadPool pool(t);
+            cout << setw(10) << timeMs([&]()
+                                       { parallel_inclusive_scan(pool, input.begin(), input.end(), output.begin(), plus<uint64_t>()); });
+        }
+        cout << endl;
+    }
+}
+
+// Tasks vacias: mide lo que cuesta entregar cada una (ahi pesan los lotes)
+static void benchShortTasks(size_t maxN)
+{
+    cout << "schedule + wait de tasks vacias (ms)" << endl;
+    cout << setw(12) << "n";
+    vector<size_t> threadCounts = {1, 2, 4, 8, 16};
+    for (size_t t : threadCounts)
+        cout << setw(10) << ("p=" + to_string(t));
+    cout << endl;
+
+    for (size_t n = 1000000; n <= maxN; n *= 10)
+    {
+        cout << setw(12) << n << fixed << setprecision(1);
+        for (size_t t : threadCounts)
+        {
+            ThreadPool pool(t);
+            atomic<size_t> ran{0};
+            cout << setw(10) << timeMs([&]()
+                                       {
+                for (size_t i = 0; i < n; ++i)
+                    pool.schedule([&ran]() { ran.fetch_add(1, memory_order_relaxed); });
+                pool.wait(); });
+        }
+        cout << endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t maxN = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000000;
+    benchSort(maxN);
+    benchScan(maxN);
+    benchShortTasks(maxN);
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef _cancellation_
+#define _cancellation_
+
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+// Token de cancelacion compartido. Todas las copias miran el mismo flag,
+// asi que cancel() es O(1) sin importar cuantas tasks lo tengan
+class CancellationToken
+{
+public:
+  CancellationToken() : flag(make_shared<atomic<bool>>(false)) {}
+
+  // Cancela todo lo que tenga este token (lo pendiente se saltea)
+  void cancel() { flag->store(true, memory_order_release); }
+
+  // Pa' que una task que ya arranco pueda fijarse y cortar antes
+  bool isCancelled() const { return flag->load(memory_order_acquire); }
+
+private:
+  shared_ptr<atomic<bool>> flag;
+};
+
+#endif
@@ -0,0 +1,521 @@
+#ifndef _channel_
+#define _channel_
+
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <coroutine>
+#include <stdexcept>
+#include <thread>
+#include "thread-pool.h"
+
+using namespace std;
+
+// Canal entre tasks del pool. receive() nunca bloquea: si no hay nada
+// registra una continuacion que se manda al pool cuando llegue un valor
+// (o con nullopt si cierran el canal). Los valores se mueven, no se copian.
+// capacity == 0 es sin limite. Con limite y el canal lleno, send(value, cb)
+// y co_await asyncSend(value) estacionan el valor y siguen cuando hay lugar;
+// send(value) bloquea el hilo, asi que solo sirve fuera de los workers.
+template <typename T>
+class Channel
+{
+public:
+  Channel(ThreadPool &pool, size_t capacity = 0);
+
+  // Bloquea mientras este lleno. Desde un worker del pool tira en vez de
+  // bloquear (el worker podria ser el que tiene que vaciar el canal)
+  void send(T value);
+  bool trySend(T &value); // false si esta lleno; value queda intacto
+
+  // Sin bloquear: si esta lleno el valor queda estacionado en el canal y
+  // onSent(true) corre en el pool cuando entra (onSent(false) si lo cierran antes)
+  void send(T value, const function<void(bool)> &onSent);
+
+  // co_await channel.asyncSend(v): false si cerraron el canal con el valor
+  // estacionado. Si ya estaba cerrado tira, igual que send()
+  struct SendAwaiter
+  {
+    Channel *channel;
+    optional<T> value;
+    bool sent;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(coroutine_handle<> h);
+    bool await_resume() const noexcept { return sent; }
+  };
+  SendAwaiter asyncSend(T value) { return SendAwaiter{this, optional<T>(move(value)), false}; }
+
+  // cb(valor) en el pool, o cb(nullopt) si el canal se cerro y esta vacio
+  void receive(const function<void(optional<T>)> &cb);
+  optional<T> tryReceive();
+
+  // co_await channel.receive(): la corutina sigue en un worker con el valor
+  struct ReceiveAwaiter
+  {
+    Channel *channel;
+    optional<T> value;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(coroutine_handle<> h);
+    optional<T> await_resume() { return move(value); }
+  };
+  ReceiveAwaiter receive() { return ReceiveAwaiter{this, nullopt}; }
+
+  // Los receive pendientes reciben nullopt y los send estacionados false;
+  // send() despues de esto tira
+  void close();
+
+  // Cierra el canal
+  ~Channel();
+
+private:
+  // Un receive esperando; el que manda le deja el valor y lo agenda
+  typedef struct receiver
+  {
+    function<void(optional<T>)> cb;
+    optional<T> value;
+  } receiver_t;
+
+  // Un send esperando lugar; su valor entra apenas alguien saque uno
+  typedef struct sender
+  {
+    T value;
+    function<void(bool)> onSent;
+  } sender_t;
+
+  void deliver(shared_ptr<receiver_t> r);
+  optional<sender_t> makeRoom();
+  void resume(optional<sender_t> s, bool sent);
+  bool park(T &value, const function<void(bool)> &onSent);
+
+  ThreadPool &pool;
+  size_t capacity;
+  mutex lock;
+  condition_variable notFull;
+  deque<T> items;
+  deque<shared_ptr<receiver_t>> receivers;
+  deque<sender_t> senders; // estacionados con el canal lleno
+  bool closed;
+
+  Channel(const Channel &original) = delete;
+  Channel &operator=(const Channel &rhs) = delete;
+};
+
+template <typename T>
+Channel<T>::Channel(ThreadPool &pool, size_t capacity) : pool(pool),
+                                                         capacity(capacity),
+                                                         closed(false) {}
+
+template <typename T>
+void Channel<T>::send(T value)
+{
+  shared_ptr<receiver_t> r;
+  {
+    unique_lock<mutex> ul(lock);
+    if (!closed && capacity != 0 && items.size() >= capacity && pool.currentWorkerId() >= 0)
+    {
+      throw runtime_error("Cannot block in Channel::send from a pool worker, use asyncSend");
+    }
+    notFull.wait(ul, [this]()
+                 { return closed || capacity == 0 || items.size() < capacity; });
+    if (closed)
+    {
+      throw runtime_error("Cannot send on closed Channel");
+    }
+    if (receivers.empty())
+    {
+      items.push_back(move(value));
+      return;
+    }
+    // Alguien ya esta esperando: el valor va directo a el
+    r = move(receivers.front());
+    receivers.pop_front();
+  }
+  r->value.emplace(move(value));
+  deliver(move(r));
+}
+
+template <typename T>
+bool Channel<T>::trySend(T &value)
+{
+  shared_ptr<receiver_t> r;
+  {
+    lock_guard<mutex> lg(lock);
+    if (closed)
+    {
+      throw runtime_error("Cannot send on closed Channel");
+    }
+    if (receivers.empty())
+    {
+      if (capacity != 0 && items.size() >= capacity)
+        return false;
+      items.push_back(move(value));
+      return true;
+    }
+    r = move(receivers.front());
+    receivers.pop_front();
+  }
+  r->value.emplace(move(value));
+  deliver(move(r));
+  return true;
+}
+
+template <typename T>
+void Channel<T>::send(T value, const function<void(bool)> &onSent)
+{
+  if (!onSent)
+  {
+    throw invalid_argument("Cannot send with null callback");
+  }
+  if (park(value, onSent))
+    return;
+  pool.schedule([onSent]()
+                { onSent(true); });
+}
+
+// Entrega value si puede (a un receive esperando o a la cola) y devuelve
+// false; si el canal esta lleno lo estaciona con onSent y devuelve true
+template <typename T>
+bool Channel<T>::park(T &value, const function<void(bool)> &onSent)
+{
+  shared_ptr<receiver_t> r;
+  {
+    lock_guard<mutex> lg(lock);
+    if (closed)
+    {
+      throw runtime_error("Cannot send on closed Channel");
+    }
+    if (receivers.empty())
+    {
+      if (capacity != 0 && items.size() >= capacity)
+      {
+        senders.push_back(sender_t{move(value), onSent});
+        return true;
+      }
+      items.push_back(move(value));
+      return false;
+    }
+    r = move(receivers.front());
+    receivers.pop_front();
+  }
+  r->value.emplace(move(value));
+  deliver(move(r));
+  return false;
+}
+
+template <typename T>
+bool Channel<T>::SendAwaiter::await_suspend(coroutine_handle<> h)
+{
+  // Si entra sin esperar seguimos sin suspender
+  sent = true;
+  return channel->park(*value, [this, h](bool ok)
+                       {
+    sent = ok;
+    h.resume(); });
+}
+
+// Con lock tomado, despues de sacar un valor: el primer send estacionado
+// ocupa el lugar que quedo (su continuacion se agenda fuera del lock)
+template <typename T>
+optional<typename Channel<T>::sender_t> Channel<T>::makeRoom()
+{
+  notFull.notify_one();
+  if (senders.empty() || (capacity != 0 && items.size() >= capacity))
+    return nullopt;
+  optional<sender_t> s(move(senders.front()));
+  senders.pop_front();
+  items.push_back(move(s->value));
+  return s;
+}
+
+template <typename T>
+void Channel<T>::resume(optional<sender_t> s, bool sent)
+{
+  if (!s)
+    return;
+  function<void(bool)> onSent = move(s->onSent);
+  pool.schedule([onSent, sent]()
+                { onSent(sent); });
+}
+
+template <typename T>
+void Channel<T>::receive(const function<void(optional<T>)> &cb)
+{
+  if (!cb)
+  {
+    throw invalid_argument("Cannot receive with null callback");
+  }
+
+  auto r = make_shared<receiver_t>();
+  r->cb = cb;
+  optional<sender_t> admitted;
+  {
+    lock_guard<mutex> lg(lock);
+    if (items.empty() && !closed)
+    {
+      receivers.push_back(move(r));
+      return;
+    }
+    if (!items.empty())
+    {
+      r->value.emplace(move(items.front()));
+      items.pop_front();
+      admitted = makeRoom();
+    }
+  }
+  deliver(move(r));
+  resume(move(admitted), true);
+}
+
+template <typename T>
+optional<T> Channel<T>::tryReceive()
+{
+  optional<T> value;
+  optional<sender_t> admitted;
+  {
+    lock_guard<mutex> lg(lock);
+    if (items.empty())
+      return nullopt;
+    value.emplace(move(items.front()));
+    items.pop_front();
+    admitted = makeRoom();
+  }
+  resume(move(admitted), true);
+  return value;
+}
+
+template <typename T>
+bool Channel<T>::ReceiveAwaiter::await_suspend(coroutine_handle<> h)
+{
+  // Si ya hay algo (o esta cerrado) seguimos sin suspender
+  optional<sender_t> admitted;
+  {
+    lock_guard<mutex> lg(channel->lock);
+    if (channel->items.empty())
+    {
+      if (channel->closed)
+        return false;
+
+      auto r = make_shared<receiver_t>();
+      r->cb = [this, h](optional<T> v)
+      {
+        value = move(v);
+        h.resume();
+      };
+      channel->receivers.push_back(move(r));
+      return true;
+    }
+    value.emplace(move(channel->items.front()));
+    channel->items.pop_front();
+    admitted = channel->makeRoom();
+  }
+  channel->resume(move(admitted), true);
+  return false;
+}
+
+template <typename T>
+void Channel<T>::deliver(shared_ptr<receiver_t> r)
+{
+  pool.schedule([r]()
+                { r->cb(move(r->value)); });
+}
+
+template <typename T>
+void Channel<T>::close()
+{
+  deque<shared_ptr<receiver_t>> pending;
+  deque<sender_t> unsent;
+  {
+    lock_guard<mutex> lg(lock);
+    if (closed)
+      return;
+    closed = true;
+    pending.swap(receivers);
+    unsent.swap(senders);
+    notFull.notify_all();
+  }
+  for (auto &r : pending)
+    deliver(move(r));
+  for (auto &s : unsent) // lo estacionado no llego a entrar
+    resume(move(s), false);
+}
+
+template <typename T>
+Channel<T>::~Channel()
+{
+  close();
+}
+
+// Canal de un solo productor y un solo consumidor sobre un ring lock-free
+// de capacidad fija (se redondea a potencia de 2). Un solo receive puede
+// estar pendiente a la vez, como corresponde a un unico consumidor, y lo
+// mismo un solo send estacionado.
+template <typename T>
+class SpscChannel
+{
+public:
+  SpscChannel(ThreadPool &pool, size_t capacity);
+
+  // Solo el productor
+  bool trySend(T &value); // false si esta lleno; value queda intacto
+
+  // Cede el hilo mientras este lleno. Desde un worker del pool tira en vez
+  // de esperar (el worker podria ser el que tiene que vaciar el canal)
+  void send(T value);
+
+  // Sin bloquear: si esta lleno el valor queda estacionado y onSent corre en
+  // el pool cuando entra. Hasta entonces el productor no manda nada mas
+  void send(T value, const function<void(void)> &onSent);
+
+  // Solo el consumidor
+  optional<T> tryReceive();
+  void receive(const function<void(T)> &cb); // cb corre en el pool
+
+private:
+  void dispatch();
+  void admit();
+
+  ThreadPool &pool;
+  vector<optional<T>> slots;
+  size_t mask;
+  alignas(64) atomic<size_t> head;       // proximo a leer (consumidor)
+  alignas(64) atomic<size_t> tail;       // proximo a escribir (productor)
+  alignas(64) atomic<bool> parked;       // hay un receive esperando
+  function<void(T)> pendingCb;           // el del receive estacionado
+  alignas(64) atomic<bool> senderParked; // hay un send esperando lugar
+  optional<T> pendingValue;              // el valor del send estacionado
+  function<void(void)> pendingSent;      // y su continuacion
+
+  SpscChannel(const SpscChannel &original) = delete;
+  SpscChannel &operator=(const SpscChannel &rhs) = delete;
+};
+
+template <typename T>
+SpscChannel<T>::SpscChannel(ThreadPool &pool, size_t capacity) : pool(pool),
+                                                                 head(0),
+                                                                 tail(0),
+                                                                 parked(false),
+                                                                 senderParked(false)
+{
+  if (capacity == 0)
+  {
+    throw invalid_argument("SpscChannel needs a positive capacity");
+  }
+  size_t size = 1;
+  while (size < capacity)
+    size <<= 1;
+  slots.resize(size);
+  mask = size - 1;
+}
+
+template <typename T>
+bool SpscChannel<T>::trySend(T &value)
+{
+  size_t t = tail.load(memory_order_relaxed);
+  if (t - head.load(memory_order_acquire) == slots.size())
+    return false;
+  slots[t & mask].emplace(move(value));
+  tail.store(t + 1, memory_order_release);
+
+  // Si el consumidor esta estacionado, el que lo saca de ahi lo agenda
+  if (parked.load(memory_order_seq_cst) && parked.exchange(false, memory_order_seq_cst))
+    dispatch();
+  return true;
+}
+
+template <typename T>
+void SpscChannel<T>::send(T value)
+{
+  if (trySend(value))
+    return;
+  if (pool.currentWorkerId() >= 0)
+  {
+    throw runtime_error("Cannot block in SpscChannel::send from a pool worker, use send(value, onSent)");
+  }
+  while (!trySend(value))
+    this_thread::yield();
+}
+
+template <typename T>
+void SpscChannel<T>::send(T value, const function<void(void)> &onSent)
+{
+  if (!onSent)
+  {
+    throw invalid_argument("Cannot send with null callback");
+  }
+  if (trySend(value))
+  {
+    pool.schedule(onSent);
+    return;
+  }
+
+  pendingValue.emplace(move(value));
+  pendingSent = onSent;
+  senderParked.store(true, memory_order_seq_cst);
+
+  // Volver a mirar: el consumidor pudo liberar lugar justo antes de ver senderParked
+  if (tail.load(memory_order_relaxed) - head.load(memory_order_seq_cst) < slots.size() &&
+      senderParked.exchange(false, memory_order_seq_cst))
+    admit();
+}
+
+// Mete el valor estacionado; lo llama quien lo saco de senderParked, con el
+// productor quieto, asi que hay lugar y nadie mas escribe
+template <typename T>
+void SpscChannel<T>::admit()
+{
+  function<void(void)> onSent = move(pendingSent);
+  trySend(*pendingValue);
+  pendingValue.reset();
+  pool.schedule(onSent);
+}
+
+template <typename T>
+optional<T> SpscChannel<T>::tryReceive()
+{
+  size_t h = head.load(memory_order_relaxed);
+  if (h == tail.load(memory_order_acquire))
+    return nullopt;
+  optional<T> value(move(*slots[h & mask]));
+  slots[h & mask].reset();
+  head.store(h + 1, memory_order_seq_cst);
+
+  // Quedo lugar: si el productor esta estacionado, lo metemos nosotros
+  if (senderParked.load(memory_order_seq_cst) && senderParked.exchange(false, memory_order_seq_cst))
+    admit();
+  return value;
+}
+
+template <typename T>
+void SpscChannel<T>::receive(const function<void(T)> &cb)
+{
+  if (!cb)
+  {
+    throw invalid_argument("Cannot receive with null callback");
+  }
+
+  pendingCb = cb;
+  parked.store(true, memory_order_seq_cst);
+
+  // Volver a mirar: el productor pudo empujar justo antes de ver parked
+  if (head.load(memory_order_relaxed) != tail.load(memory_order_seq_cst) &&
+      parked.exchange(false, memory_order_seq_cst))
+    dispatch();
+}
+
+template <typename T>
+void SpscChannel<T>::dispatch()
+{
+  function<void(T)> cb = move(pendingCb);
+  pool.schedule([this, cb]()
+                { cb(move(*tryReceive())); });
+}
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef _coro_task_
+#define _coro_task_
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include "thread-pool.h"
+
+using namespace std;
+
+// task<T>: corutina lazy, arranca recien cuando alguien le hace co_await.
+// Cuando termina le pasa el control directo a quien la espero (symmetric
+// transfer), asi que si la retomo un worker sigue en ese mismo worker.
+template <typename T>
+class task;
+
+namespace coro_detail
+{
+  // Al terminar saltamos a la continuacion (o a ningun lado)
+  struct final_awaiter
+  {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename P>
+    coroutine_handle<> await_suspend(coroutine_handle<P> h) noexcept
+    {
+      coroutine_handle<> next = h.promise().continuation;
+      return next ? next : noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  struct promise_base
+  {
+    coroutine_handle<> continuation;
+    exception_ptr error;
+
+    suspend_always initial_suspend() noexcept { return {}; }
+    final_awaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = current_exception(); }
+  };
+}
+
+template <typename T>
+class task
+{
+public:
+  struct promise_type : coro_detail::promise_base
+  {
+    optional<T> value;
+
+    task get_return_object() { return task(coroutine_handle<promise_type>::from_promise(*this)); }
+    template <typename U>
+    void return_value(U &&v) { value.emplace(forward<U>(v)); }
+  };
+
+  task(task &&other) noexcept : h(exchange(other.h, nullptr)) {}
+  task &operator=(task &&other) noexcept
+  {
+    if (this != &other)
+    {
+      if (h)
+        h.destroy();
+      h = exchange(other.h, nullptr);
+    }
+    return *this;
+  }
+  ~task()
+  {
+    if (h)
+      h.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  coroutine_handle<> await_suspend(coroutine_handle<> awaiting)
+  {
+    h.promise().continuation = awaiting;
+    return h; // arrancamos la corutina en este mismo hilo
+  }
+  T await_resume()
+  {
+    if (h.promise().error)
+      rethrow_exception(h.promise().error);
+    return move(*h.promise().value);
+  }
+
+private:
+  explicit task(coroutine_handle<promise_type> handle) : h(handle) {}
+  coroutine_handle<promise_type> h;
+
+  task(const task &) = delete;
+  task &operator=(const task &) = delete;
+};
+
+template <>
+class task<void>
+{
+public:
+  struct promise_type : coro_detail::promise_base
+  {
+    task get_return_object() { return task(coroutine_handle<promise_type>::from_promise(*this)); }
+    void return_void() {}
+  };
+
+  task(task &&other) noexcept : h(exchange(other.h, nullptr)) {}
+  task &operator=(task &&other) noexcept
+  {
+    if (this != &other)
+    {
+      if (h)
+        h.destroy();
+      h = exchange(other.h, nullptr);
+    }
+    return *this;
+  }
+  ~task()
+  {
+    if (h)
+      h.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  coroutine_handle<> await_suspend(coroutine_handle<> awaiting)
+  {
+    h.promise().continuation = awaiting;
+    return h;
+  }
+  void await_resume()
+  {
+    if (h.promise().error)
+      rethrow_exception(h.promise().error);
+  }
+
+private:
+  explicit task(coroutine_handle<promise_type> handle) : h(handle) {}
+  coroutine_handle<promise_type> h;
+
+  task(const task &) = delete;
+  task &operator=(const task &) = delete;
+};
+
+namespace coro_detail
+{
+  // Corutina auxiliar de sync_wait: espera la task y despierta al hilo bloqueado
+  struct sync_waiter
+  {
+    mutex m;
+    condition_variable cv;
+    bool finished = false;
+  };
+
+  struct sync_task
+  {
+    struct promise_type
+    {
+      sync_waiter *waiter = nullptr;
+
+      sync_task get_return_object() { return sync_task(coroutine_handle<promise_type>::from_promise(*this)); }
+      suspend_always initial_suspend() noexcept { return {}; }
+      auto final_suspend() noexcept
+      {
+        struct notifier
+        {
+          bool await_ready() const noexcept { return false; }
+          void await_suspend(coroutine_handle<promise_type> h) noexcept
+          {
+            sync_waiter *w = h.promise().waiter;
+            lock_guard<mutex> lg(w->m);
+            w->finished = true;
+            w->cv.notify_all();
+          }
+          void await_resume() const noexcept {}
+        };
+        return notifier{};
+      }
+      void return_void() {}
+      void unhandled_exception() { terminate(); } // las excepciones ya las guarda la task
+    };
+
+    explicit sync_task(coroutine_handle<promise_type> handle) : h(handle) {}
+    sync_task(sync_task &&other) noexcept : h(exchange(other.h, nullptr)) {}
+    ~sync_task()
+    {
+      if (h)
+        h.destroy();
+    }
+
+    coroutine_handle<promise_type> h;
+  };
+}
+
+// Bloquea el hilo actual hasta que termine la task y devuelve su resultado.
+// No llamarlo desde un worker del mismo pool (mismo problema que wait())
+template <typename T>
+T sync_wait(task<T> t)
+{
+  optional<T> result;
+  exception_ptr error;
+  auto body = [&]() -> coro_detail::sync_task
+  {
+    try
+    {
+      result.emplace(co_await move(t));
+    }
+    catch (...)
+    {
+      error = current_exception();
+    }
+  };
+
+  coro_detail::sync_waiter waiter;
+  coro_detail::sync_task driver = body();
+  driver.h.promise().waiter = &waiter;
+  driver.h.resume();
+  {
+    unique_lock<mutex> ul(waiter.m);
+    waiter.cv.wait(ul, [&waiter]()
+                   { return waiter.finished; });
+  }
+  if (error)
+    rethrow_exception(error);
+  return move(*result);
+}
+
+inline void sync_wait(task<void> t)
+{
+  exception_ptr error;
+  auto body = [&]() -> coro_detail::sync_task
+  {
+    try
+    {
+      co_await move(t);
+    }
+    catch (...)
+    {
+      error = current_exception();
+    }
+  };
+
+  coro_detail::sync_waiter waiter;
+  coro_detail::sync_task driver = body();
+  driver.h.promise().waiter = &waiter;
+  driver.h.resume();
+  {
+    unique_lock<mutex> ul(waiter.m);
+    waiter.cv.wait(ul, [&waiter]()
+                   { return waiter.finished; });
+  }
+  if (error)
+    rethrow_exception(error);
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "executor.h"
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+using namespace std;
+
+static size_t coresOr(size_t n)
+{
+    return n != 0 ? n : max(1u, thread::hardware_concurrency());
+}
+
+CompositeExecutor::CompositeExecutor(size_t cpuThreads, size_t maxBlockingThreads)
+    : inFlight(0),
+      cpuPool(coresOr(cpuThreads)),
+      blockingPool(min(coresOr(cpuThreads), max<size_t>(maxBlockingThreads, 1)), maxBlockingThreads)
+{
+}
+
+// Cada task suma antes de entrar a un pool y resta cuando termino, despues
+// de haber programado lo que pase al otro: el contador nunca llega a 0 en
+// medio de un pase de mano
+void CompositeExecutor::schedule(const function<void(void)> &thunk)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot schedule null function");
+    }
+    track();
+    cpuPool.schedule([this, thunk]()
+                     {
+        thunk();
+        untrack(); });
+}
+
+void CompositeExecutor::scheduleBlocking(const function<void(void)> &thunk)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot schedule null function");
+    }
+    track();
+    blockingPool.schedule([this, thunk]()
+                          {
+        {
+            ThreadPool::blocking_region region(blockingPool);
+            thunk();
+        }
+        untrack(); });
+}
+
+void CompositeExecutor::hop(coroutine_handle<> h, bool toBlocking)
+{
+    track();
+    if (toBlocking)
+    {
+        blockingPool.schedule([this, h]()
+                              {
+            {
+                ThreadPool::blocking_region region(blockingPool);
+                h.resume(); // vuelve cuando la corutina salta de nuevo o termina
+            }
+            untrack(); });
+    }
+    else
+    {
+        cpuPool.schedule([this, h]()
+                         {
+            h.resume();
+            untrack(); });
+    }
+}
+
+void CompositeExecutor::untrack()
+{
+    if (inFlight.fetch_sub(1, memory_order_acq_rel) == 1)
+    {
+        lock_guard<mutex> lg(idleLock);
+        idle.notify_all();
+    }
+}
+
+void CompositeExecutor::wait()
+{
+    while (true)
+    {
+        {
+            unique_lock<mutex> ul(idleLock);
+            idle.wait(ul, [this]()
+                      { return inFlight.load(memory_order_acquire) == 0; });
+        }
+
+        // Lo programado directo en los pools (y que terminen de anotar lo suyo)
+        cpuPool.wait();
+        blockingPool.wait();
+        if (inFlight.load(memory_order_acquire) == 0)
+            return;
+    }
+}
+
+CompositeExecutor::~CompositeExecutor()
+{
+    wait();
+}
@@ -0,0 +1,75 @@
+#ifndef _executor_
+#define _executor_
+
+#include <cstddef>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <coroutine>
+#include "thread-pool.h"
+
+using namespace std;
+
+// Executor compuesto: un pool de computo con un worker por core y otro
+// elastico pa' lo que bloquea (disco, sleeps, locks ajenos). El de bloqueo
+// tiene tantos workers fijos como el de computo y cada task bloqueante corre
+// en un blocking_region, asi que el pool suma un hilo por cada una que esta
+// bloqueada (hasta maxBlockingThreads) y los que sobran se retiran cuando
+// vuelven. Lo que bloquea nunca le saca workers al computo.
+class CompositeExecutor
+{
+public:
+  // cpuThreads = 0 es un worker por core
+  CompositeExecutor(size_t cpuThreads = 0, size_t maxBlockingThreads = 256);
+
+  // Task de computo
+  void schedule(const function<void(void)> &thunk);
+
+  // Task que puede bloquear
+  void scheduleBlocking(const function<void(void)> &thunk);
+
+  // Salto de una corutina a uno de los pools; cuenta pa' wait() hasta que
+  // la corutina vuelve a suspenderse o termina
+  struct HopAwaiter
+  {
+    CompositeExecutor *ex;
+    bool toBlocking;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(coroutine_handle<> h) { ex->hop(h, toBlocking); }
+    void await_resume() const noexcept {}
+  };
+
+  // Desde una corutina: co_await ex.enterBlocking() sigue en el pool de
+  // bloqueo y co_await ex.leaveBlocking() vuelve al de computo
+  HopAwaiter enterBlocking() { return HopAwaiter{this, true}; }
+  HopAwaiter leaveBlocking() { return HopAwaiter{this, false}; }
+
+  ThreadPool &cpu() { return cpuPool; }
+  ThreadPool &blocking() { return blockingPool; }
+
+  // Espera hasta que no quede nada de lo que paso por el executor, aunque
+  // las tasks de un pool sigan programando en el otro. Lo que se programa
+  // directo en cpu() o blocking() se espera con el wait() de cada pool
+  void wait();
+
+  ~CompositeExecutor();
+
+private:
+  void hop(coroutine_handle<> h, bool toBlocking);
+  void track() { inFlight.fetch_add(1, memory_order_relaxed); }
+  void untrack();
+
+  // Van antes que los pools: los workers los tocan hasta que se los joinea
+  atomic<size_t> inFlight; // tasks y saltos del executor sin terminar
+  mutex idleLock;
+  condition_variable idle;
+
+  ThreadPool cpuPool;
+  ThreadPool blockingPool;
+
+  CompositeExecutor(const CompositeExecutor &original) = delete;
+  CompositeExecutor &operator=(const CompositeExecutor &rhs) = delete;
+};
+
+#endif
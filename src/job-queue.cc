@@ -0,0 +1,117 @@
+#include "job-queue.h"
+#include <mutex>
+#include <vector>
+#include <memory>
+using namespace std;
+
+static const size_t kSlabNodes = 256; // nodos que se piden juntos
+static const size_t kCacheBatch = 64; // lo que se mueve entre cache y pool global
+
+// Pool global de nodos libres. Se reserva con new y nunca se destruye a
+// proposito: hilos detacheados pueden seguir devolviendo nodos al salir
+typedef struct node_pool
+{
+  mutex lock;
+  job_node_t *free = nullptr;
+  size_t count = 0;
+  vector<unique_ptr<job_node_t[]>> slabs;
+} node_pool_t;
+
+static node_pool_t &globalPool()
+{
+  static node_pool_t *pool = new node_pool_t();
+  return *pool;
+}
+
+// Cache por hilo: alloc y free normales no tocan ningun lock
+typedef struct node_cache
+{
+  job_node_t *free = nullptr;
+  size_t count = 0;
+
+  ~node_cache()
+  {
+    if (!free)
+      return;
+    job_node_t *last = free;
+    while (last->next.load(memory_order_relaxed))
+      last = last->next.load(memory_order_relaxed);
+
+    node_pool_t &g = globalPool();
+    lock_guard<mutex> lg(g.lock);
+    last->next.store(g.free, memory_order_relaxed);
+    g.free = free;
+    g.count += count;
+  }
+} node_cache_t;
+
+static thread_local node_cache_t cache;
+
+// Trae hasta kCacheBatch nodos del pool global, armando un slab si hace falta
+static void refill()
+{
+  node_pool_t &g = globalPool();
+  lock_guard<mutex> lg(g.lock);
+  if (g.count == 0)
+  {
+    unique_ptr<job_node_t[]> slab(new job_node_t[kSlabNodes]);
+    for (size_t i = 0; i < kSlabNodes; i++)
+    {
+      slab[i].next.store(g.free, memory_order_relaxed);
+      g.free = &slab[i];
+    }
+    g.count += kSlabNodes;
+    g.slabs.push_back(move(slab));
+  }
+
+  size_t n = 0;
+  while (n < kCacheBatch && g.free)
+  {
+    job_node_t *node = g.free;
+    g.free = node->next.load(memory_order_relaxed);
+    node->next.store(cache.free, memory_order_relaxed);
+    cache.free = node;
+    n++;
+  }
+  g.count -= n;
+  cache.count += n;
+}
+
+job_node_t *allocJobNode()
+{
+  if (!cache.free)
+    refill();
+
+  job_node_t *node = cache.free;
+  cache.free = node->next.load(memory_order_relaxed);
+  cache.count--;
+  node->next.store(nullptr, memory_order_relaxed);
+  return node;
+}
+
+void freeJobNode(job_node_t *node)
+{
+  node->job = job_t(); // soltar capturas/token antes de guardarlo
+
+  node->next.store(cache.free, memory_order_relaxed);
+  cache.free = node;
+  cache.count++;
+
+  // El dispatcher libera lo que alocan los productores: devolver el
+  // sobrante al pool global pa' que no se acumule en un solo hilo
+  if (cache.count > 2 * kCacheBatch)
+  {
+    job_node_t *first = cache.free;
+    job_node_t *last = first;
+    for (size_t i = 1; i < kCacheBatch; i++)
+      last = last->next.load(memory_order_relaxed);
+    cache.free = last->next.load(memory_order_relaxed);
+    cache.count -= kCacheBatch;
+
+    node_pool_t &g = globalPool();
+    lock_guard<mutex> lg(g.lock);
+    last->next.store(g.free, memory_order_relaxed);
+    g.free = first;
+    g.count += kCacheBatch;
+  }
+}
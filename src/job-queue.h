@@ -0,0 +1,208 @@
+#ifndef _job_queue_
+#define _job_queue_
+
+#include <cstddef>
+#include <functional>
+#include <coroutine>
+#include <optional>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "cancellation.h"
+
+using namespace std;
+
+// Callable de una task con lugar propio en el nodo: una lambda cuyas
+// capturas entran en kInlineSize se construye ahi adentro sin malloc (el
+// buffer de function es de 16 bytes). Las mas grandes van al heap una vez
+class InlineThunk
+{
+public:
+  static constexpr size_t kInlineSize = 64;
+
+  InlineThunk() = default;
+  InlineThunk(InlineThunk &&other) noexcept { take(other); }
+  InlineThunk &operator=(InlineThunk &&other) noexcept
+  {
+    if (this != &other)
+    {
+      reset();
+      take(other);
+    }
+    return *this;
+  }
+  ~InlineThunk() { reset(); }
+
+  template <typename F>
+  void emplace(F &&fn)
+  {
+    typedef decay_t<F> fn_t;
+    reset();
+    if constexpr (fitsInline<fn_t>())
+      new (storage) fn_t(forward<F>(fn));
+    else
+      *reinterpret_cast<fn_t **>(storage) = new fn_t(forward<F>(fn));
+    ops = &opsFor<fn_t>;
+  }
+
+  explicit operator bool() const { return ops != nullptr; }
+  void operator()() { ops->call(storage); }
+
+  void reset()
+  {
+    if (ops)
+      ops->destroy(storage);
+    ops = nullptr;
+  }
+
+private:
+  typedef struct ops
+  {
+    void (*call)(void *);
+    void (*move)(void *dst, void *src); // construye en dst y destruye src
+    void (*destroy)(void *);
+  } ops_t;
+
+  template <typename F>
+  static constexpr bool fitsInline()
+  {
+    return sizeof(F) <= kInlineSize && alignof(F) <= alignof(max_align_t) &&
+           is_nothrow_move_constructible_v<F>;
+  }
+
+  template <typename F>
+  static constexpr ops_t makeOps()
+  {
+    if constexpr (fitsInline<F>())
+      return ops_t{[](void *p)
+                   { (*static_cast<F *>(p))(); },
+                   [](void *dst, void *src)
+                   {
+                     new (dst) F(move(*static_cast<F *>(src)));
+                     static_cast<F *>(src)->~F();
+                   },
+                   [](void *p)
+                   { static_cast<F *>(p)->~F(); }};
+    else
+      return ops_t{[](void *p)
+                   { (**static_cast<F **>(p))(); },
+                   [](void *dst, void *src)
+                   { *static_cast<F **>(dst) = *static_cast<F **>(src); },
+                   [](void *p)
+                   { delete *static_cast<F **>(p); }};
+  }
+
+  template <typename F>
+  static constexpr ops_t opsFor = makeOps<F>();
+
+  void take(InlineThunk &other)
+  {
+    if (other.ops)
+      other.ops->move(storage, other.storage);
+    ops = other.ops;
+    other.ops = nullptr;
+  }
+
+  alignas(max_align_t) unsigned char storage[kInlineSize];
+  const ops_t *ops = nullptr;
+
+  InlineThunk(const InlineThunk &original) = delete;
+  InlineThunk &operator=(const InlineThunk &rhs) = delete;
+};
+
+// Lo que va en la cola: un thunk comun o una corutina pa' retomar.
+// El handle son 8 bytes, asi que las corutinas no pasan por el thunk
+typedef struct job
+{
+  InlineThunk thunk;
+  coroutine_handle<> handle;
+  optional<CancellationToken> token; // opcional, vacio no aloca nada
+  int affinity = -1;                 // worker fijo pa' scheduleOn, -1 = cualquiera
+  chrono::steady_clock::time_point enqueued; // solo con admission control, pa' el sojourn
+  const char *name = nullptr;                // pa' los reportes del watchdog (string estatico)
+  bool cheap = false;                        // programada con kTaskCheap
+
+  bool cancelled() const { return token && token->isCancelled(); }
+
+  void run()
+  {
+    if (handle)
+      handle.resume();
+    else
+      thunk();
+  }
+} job_t;
+
+// Nodo de la cola intrusiva. Salen de slabs reciclados, no de malloc.
+// next es atomico pa' que LockFreeQueue pueda enlazar sin lock
+typedef struct job_node
+{
+  job_t job;
+  atomic<job_node *> next{nullptr};
+} job_node_t;
+
+// Saca un nodo vacio del cache del hilo (o del pool global si se vacio).
+// Solo se pide memoria nueva cuando no queda ningun nodo libre en ningun lado
+job_node_t *allocJobNode();
+
+// Suelta las capturas del job y devuelve el nodo al cache del hilo
+void freeJobNode(job_node_t *node);
+
+// Cola FIFO intrusiva de nodos. No es thread-safe, la protege el que la usa
+class JobQueue
+{
+public:
+  JobQueue() : head(nullptr), tail(nullptr), count(0) {}
+
+  bool empty() const { return head == nullptr; }
+  size_t size() const { return count; }
+
+  void push(job_node_t *node)
+  {
+    node->next.store(nullptr, memory_order_relaxed);
+    if (tail)
+      tail->next.store(node, memory_order_relaxed);
+    else
+      head = node;
+    tail = node;
+    count++;
+  }
+
+  job_node_t *pop()
+  {
+    job_node_t *node = head;
+    if (node)
+    {
+      head = node->next.load(memory_order_relaxed);
+      if (!head)
+        tail = nullptr;
+      node->next.store(nullptr, memory_order_relaxed);
+      count--;
+    }
+    return node;
+  }
+
+  // Pasa todos los nodos de other al final de esta cola en O(1)
+  void splice(JobQueue &other)
+  {
+    if (!other.head)
+      return;
+    if (tail)
+      tail->next.store(other.head, memory_order_relaxed);
+    else
+      head = other.head;
+    tail = other.tail;
+    count += other.count;
+    other.head = other.tail = nullptr;
+    other.count = 0;
+  }
+
+private:
+  job_node_t *head;
+  job_node_t *tail;
+  size_t count;
+};
+
+#endif
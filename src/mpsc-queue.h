@@ -0,0 +1,66 @@
+#ifndef _mpsc_queue_
+#define _mpsc_queue_
+
+#include <atomic>
+
+using namespace std;
+
+// Cola MPSC lock-free (Vyukov) intrusiva: Node tiene que tener un
+// atomic<Node *> next. Los productores empujan con un exchange; pop() es de
+// un solo consumidor y no usa atomicos caros. La cola no es duenia de los nodos
+template <typename Node>
+class MpscQueue
+{
+public:
+  MpscQueue() : head(&stub), tail(&stub) { stub.next.store(nullptr, memory_order_relaxed); }
+
+  void push(Node *node)
+  {
+    node->next.store(nullptr, memory_order_relaxed);
+    Node *prev = tail.exchange(node, memory_order_acq_rel);
+    prev->next.store(node, memory_order_release);
+  }
+
+  // nullptr si esta vacia o si un productor esta a mitad del push (en ese
+  // caso el que empuja ya va a avisar por su lado)
+  Node *pop()
+  {
+    Node *h = head;
+    Node *next = h->next.load(memory_order_acquire);
+    if (h == &stub)
+    {
+      if (!next)
+        return nullptr;
+      head = next;
+      h = next;
+      next = next->next.load(memory_order_acquire);
+    }
+    if (next)
+    {
+      head = next;
+      return h;
+    }
+
+    // h es el ultimo: volver a meter el stub pa' poder sacarlo
+    if (h != tail.load(memory_order_acquire))
+      return nullptr;
+    push(&stub);
+    next = h->next.load(memory_order_acquire);
+    if (next)
+    {
+      head = next;
+      return h;
+    }
+    return nullptr;
+  }
+
+private:
+  Node stub;            // nodo centinela
+  Node *head;           // solo lo toca el consumidor
+  atomic<Node *> tail;  // donde empujan los productores
+
+  MpscQueue(const MpscQueue &original) = delete;
+  MpscQueue &operator=(const MpscQueue &rhs) = delete;
+};
+
+#endif
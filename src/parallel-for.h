@@ -0,0 +1,65 @@
+#ifndef _parallel_for_
+#define _parallel_for_
+
+#include <cstddef>
+#include <exception>
+#include "thread-pool.h"
+
+using namespace std;
+
+namespace parallel_detail
+{
+  // Corre body adentro de un worker del pool y espera solo eso. Si ya
+  // estamos en un worker lo corre directo: los deques fork-join estan a mano
+  template <typename Pool, typename F>
+  void runOnPool(Pool &pool, F &&body)
+  {
+    if (pool.currentWorkerId() >= 0)
+    {
+      body();
+      return;
+    }
+
+    Semaphore finished;
+    exception_ptr error;
+    pool.schedule([&]()
+                  {
+        try {
+            body();
+        } catch (...) {
+            error = current_exception();
+        }
+        finished.signal(); });
+    finished.wait();
+    if (error)
+      rethrow_exception(error);
+  }
+
+  template <typename Pool, typename F>
+  void forRange(Pool &pool, size_t begin, size_t end, F &fn)
+  {
+    if (end - begin == 1)
+    {
+      fn(begin);
+      return;
+    }
+    size_t mid = begin + (end - begin) / 2;
+    pool.invoke([&]()
+                { forRange(pool, begin, mid, fn); },
+                [&]()
+                { forRange(pool, mid, end, fn); });
+  }
+}
+
+// Llama fn(i) para cada i en [begin, end) repartido en el pool con
+// fork-join. Cada i deberia ser un bloque de trabajo, no un elemento
+template <typename Pool, typename F>
+void parallel_for(Pool &pool, size_t begin, size_t end, F fn)
+{
+  if (begin >= end)
+    return;
+  parallel_detail::runOnPool(pool, [&]()
+                             { parallel_detail::forRange(pool, begin, end, fn); });
+}
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef _parallel_scan_
+#define _parallel_scan_
+
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <vector>
+#include <utility>
+#include <functional>
+#include "parallel-for.h"
+
+using namespace std;
+
+// Prefix sums en dos pasadas por bloques:
+//   1. reduce de cada bloque en paralelo
+//   2. scan secuencial de los totales (son pocos)
+//   3. scan de cada bloque en paralelo arrancando de su offset
+// op tiene que ser asociativa (no hace falta que sea conmutativa).
+// La salida tiene que ser random access; puede ser el mismo rango de entrada.
+
+namespace scan_detail
+{
+  // Un bloque de entrada + uno de salida tienen que entrar en L2
+  constexpr size_t kL2Bytes = 256 * 1024;
+  constexpr size_t kMinBlock = 1024;
+
+  template <typename T>
+  constexpr size_t blockSize()
+  {
+    return max(kMinBlock, kL2Bytes / (2 * sizeof(T)));
+  }
+
+  inline size_t blockCount(size_t n, size_t block)
+  {
+    return (n + block - 1) / block;
+  }
+
+  // Total de cada bloque menos el ultimo (al ultimo nadie lo usa de offset)
+  template <typename Pool, typename InIt, typename T, typename Op>
+  vector<T> blockTotals(Pool &pool, InIt first, size_t n, size_t block, Op &op)
+  {
+    size_t blocks = blockCount(n, block);
+    vector<T> totals(blocks - 1);
+    parallel_for(pool, 0, blocks - 1, [&](size_t b)
+                 {
+            InIt lo = first + b * block;
+            totals[b] = accumulate(next(lo), lo + block, T(*lo), op); });
+    return totals;
+  }
+}
+
+template <typename Pool, typename InIt, typename OutIt, typename Op>
+OutIt parallel_inclusive_scan(Pool &pool, InIt first, InIt last, OutIt d_first, Op op)
+{
+  typedef typename iterator_traits<InIt>::value_type value_type;
+  size_t n = last - first;
+  size_t block = scan_detail::blockSize<value_type>();
+  if (n <= block || pool.size() <= 1)
+    return inclusive_scan(first, last, d_first, op);
+
+  vector<value_type> carry = scan_detail::blockTotals<Pool, InIt, value_type>(pool, first, n, block, op);
+  for (size_t b = 1; b < carry.size(); ++b)
+    carry[b] = op(carry[b - 1], carry[b]);
+
+  parallel_for(pool, 0, scan_detail::blockCount(n, block), [&](size_t b)
+               {
+        InIt lo = first + b * block;
+        InIt hi = lo + min(block, n - b * block);
+        if (b == 0)
+            inclusive_scan(lo, hi, d_first, op);
+        else
+            inclusive_scan(lo, hi, d_first + b * block, op, carry[b - 1]); });
+  return d_first + n;
+}
+
+template <typename Pool, typename InIt, typename OutIt>
+OutIt parallel_inclusive_scan(Pool &pool, InIt first, InIt last, OutIt d_first)
+{
+  return parallel_inclusive_scan(pool, first, last, d_first, plus<>());
+}
+
+template <typename Pool, typename InIt, typename OutIt, typename T, typename Op>
+OutIt parallel_exclusive_scan(Pool &pool, InIt first, InIt last, OutIt d_first, T init, Op op)
+{
+  size_t n = last - first;
+  size_t block = scan_detail::blockSize<T>();
+  if (n <= block || pool.size() <= 1)
+    return exclusive_scan(first, last, d_first, init, op);
+
+  // carry[b] es lo que va antes del bloque b
+  vector<T> carry = scan_detail::blockTotals<Pool, InIt, T>(pool, first, n, block, op);
+  carry.insert(carry.begin(), init);
+  for (size_t b = 1; b < carry.size(); ++b)
+    carry[b] = op(carry[b - 1], carry[b]);
+
+  parallel_for(pool, 0, carry.size(), [&](size_t b)
+               {
+        InIt lo = first + b * block;
+        InIt hi = lo + min(block, n - b * block);
+        exclusive_scan(lo, hi, d_first + b * block, carry[b], op); });
+  return d_first + n;
+}
+
+template <typename Pool, typename InIt, typename OutIt, typename T>
+OutIt parallel_exclusive_scan(Pool &pool, InIt first, InIt last, OutIt d_first, T init)
+{
+  return parallel_exclusive_scan(pool, first, last, d_first, init, plus<>());
+}
+
+// Compactacion con el mismo esquema: se cuentan los que pasan por bloque,
+// el scan de los conteos da donde escribe cada bloque. Es estable.
+// pred se evalua dos veces por elemento, asi que tiene que ser pura.
+template <typename Pool, typename InIt, typename OutIt, typename Pred>
+OutIt parallel_copy_if(Pool &pool, InIt first, InIt last, OutIt d_first, Pred pred)
+{
+  typedef typename iterator_traits<InIt>::value_type value_type;
+  size_t n = last - first;
+  size_t block = scan_detail::blockSize<value_type>();
+  if (n <= block || pool.size() <= 1)
+    return copy_if(first, last, d_first, pred);
+
+  size_t blocks = scan_detail::blockCount(n, block);
+  vector<size_t> offsets(blocks + 1, 0);
+  parallel_for(pool, 0, blocks, [&](size_t b)
+               {
+        InIt lo = first + b * block;
+        offsets[b + 1] = count_if(lo, lo + min(block, n - b * block), pred); });
+  partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  parallel_for(pool, 0, blocks, [&](size_t b)
+               {
+        InIt lo = first + b * block;
+        copy_if(lo, lo + min(block, n - b * block), d_first + offsets[b], pred); });
+  return d_first + offsets[blocks];
+}
+
+// Como partition_copy: los que cumplen a d_true, el resto a d_false,
+// los dos en orden. Devuelve el final de cada salida
+template <typename Pool, typename InIt, typename OutTrue, typename OutFalse, typename Pred>
+pair<OutTrue, OutFalse> parallel_partition_copy(Pool &pool, InIt first, InIt last,
+                                                OutTrue d_true, OutFalse d_false, Pred pred)
+{
+  typedef typename iterator_traits<InIt>::value_type value_type;
+  size_t n = last - first;
+  size_t block = scan_detail::blockSize<value_type>();
+  if (n <= block || pool.size() <= 1)
+    return partition_copy(first, last, d_true, d_false, pred);
+
+  // Los que no cumplen de un bloque se deducen del tamano del bloque
+  size_t blocks = scan_detail::blockCount(n, block);
+  vector<size_t> offsets(blocks + 1, 0);
+  parallel_for(pool, 0, blocks, [&](size_t b)
+               {
+        InIt lo = first + b * block;
+        offsets[b + 1] = count_if(lo, lo + min(block, n - b * block), pred); });
+  partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  parallel_for(pool, 0, blocks, [&](size_t b)
+               {
+        InIt lo = first + b * block;
+        size_t before = b * block;
+        partition_copy(lo, lo + min(block, n - before),
+                       d_true + offsets[b], d_false + (before - offsets[b]), pred); });
+  return make_pair(d_true + offsets[blocks], d_false + (n - offsets[blocks]));
+}
+
+#endif
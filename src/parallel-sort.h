@@ -0,0 +1,102 @@
+#ifndef _parallel_sort_
+#define _parallel_sort_
+
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <functional>
+#include "parallel-for.h"
+
+using namespace std;
+
+// Merge sort paralelo sobre los workers del pool, armado con invoke():
+// las dos mitades y los dos pedazos de cada merge son ramas fork-join.
+// Usa un solo buffer temporal de n elementos (el tipo tiene que poder
+// construirse por defecto) y va alternando entre el rango y el buffer.
+// Por debajo del cutoff cae a std::sort.
+
+namespace sort_detail
+{
+  // Menos que esto no vale la pena repartirlo
+  constexpr ptrdiff_t kSortCutoff = 1 << 13;
+  constexpr ptrdiff_t kMergeCutoff = 1 << 13;
+
+  // Mezcla [a1, a2) y [b1, b2) en out partiendo por la mediana del mas largo
+  template <typename Pool, typename InIt, typename OutIt, typename Compare>
+  void parallelMerge(Pool &pool, InIt a1, InIt a2, InIt b1, InIt b2, OutIt out, Compare &cmp)
+  {
+    ptrdiff_t na = a2 - a1, nb = b2 - b1;
+    if (na + nb <= kMergeCutoff)
+    {
+      merge(make_move_iterator(a1), make_move_iterator(a2),
+            make_move_iterator(b1), make_move_iterator(b2), out, cmp);
+      return;
+    }
+    if (na < nb)
+    {
+      swap(a1, b1);
+      swap(a2, b2);
+      swap(na, nb);
+    }
+
+    InIt am = a1 + na / 2;
+    InIt bm = lower_bound(b1, b2, *am, cmp);
+    OutIt outMid = out + (am - a1) + (bm - b1);
+    pool.invoke([&]()
+                { parallelMerge(pool, a1, am, b1, bm, out, cmp); },
+                [&]()
+                { parallelMerge(pool, am, a2, bm, b2, outMid, cmp); });
+  }
+
+  // Ordena [a, a + n); el resultado queda en a si resultInA, si no en b
+  template <typename Pool, typename It, typename BufIt, typename Compare>
+  void sortInto(Pool &pool, It a, BufIt b, ptrdiff_t n, bool resultInA, ptrdiff_t leaf, Compare &cmp)
+  {
+    if (n <= leaf)
+    {
+      sort(a, a + n, cmp);
+      if (!resultInA)
+        move(a, a + n, b);
+      return;
+    }
+
+    // Las mitades quedan ordenadas del otro lado y el merge las trae de vuelta
+    ptrdiff_t h = n / 2;
+    pool.invoke([&]()
+                { sortInto(pool, a, b, h, !resultInA, leaf, cmp); },
+                [&]()
+                { sortInto(pool, a + h, b + h, n - h, !resultInA, leaf, cmp); });
+
+    if (resultInA)
+      parallelMerge(pool, b, b + h, b + h, b + n, a, cmp);
+    else
+      parallelMerge(pool, a, a + h, a + h, a + n, b, cmp);
+  }
+}
+
+template <typename Pool, typename RandomIt, typename Compare>
+void parallel_sort(Pool &pool, RandomIt first, RandomIt last, Compare cmp)
+{
+  typedef typename iterator_traits<RandomIt>::value_type value_type;
+  ptrdiff_t n = last - first;
+  if (n <= sort_detail::kSortCutoff || pool.size() <= 1)
+  {
+    sort(first, last, cmp);
+    return;
+  }
+
+  // Hojas de al menos n / (8 * workers) pa' no pagar de mas en fork-joins
+  ptrdiff_t leaf = max<ptrdiff_t>(sort_detail::kSortCutoff, n / (8 * (ptrdiff_t)pool.size()));
+  vector<value_type> buffer(n);
+  parallel_detail::runOnPool(pool, [&]()
+                             { sort_detail::sortInto(pool, first, buffer.begin(), n, true, leaf, cmp); });
+}
+
+template <typename Pool, typename RandomIt>
+void parallel_sort(Pool &pool, RandomIt first, RandomIt last)
+{
+  parallel_sort(pool, first, last, less<typename iterator_traits<RandomIt>::value_type>());
+}
+
+#endif
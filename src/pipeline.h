@@ -0,0 +1,318 @@
+#ifndef _pipeline_
+#define _pipeline_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <atomic>
+#include "thread-pool.h"
+
+using namespace std;
+
+// Como corre cada etapa del pipeline
+enum stage_mode
+{
+  kStageParallel,         // varios tokens a la vez
+  kStageSerialInOrder,    // de a uno y en el orden en que los leyo la fuente
+  kStageSerialOutOfOrder, // de a uno, en cualquier orden
+};
+
+// Pipeline acotado estilo TBB arriba del ThreadPool: una fuente serial
+// llena tokens (slots de T que se reciclan) y cada token pasa por las etapas.
+// Nunca hay mas de maxTokens en vuelo, asi que la memoria queda acotada y la
+// fuente frena sola. Una task lleva a su token por todas las etapas que
+// pueda seguidas (los datos quedan calientes en ese worker); si una etapa
+// serial esta ocupada, el token queda estacionado y lo sigue el que la libere.
+template <typename T>
+class Pipeline
+{
+public:
+  Pipeline(ThreadPool &pool, size_t maxTokens);
+
+  // Llena el token con el proximo item; false cuando no hay mas entrada
+  Pipeline &source(const function<bool(T &)> &fn);
+
+  // Agrega una etapa al final
+  Pipeline &stage(stage_mode mode, const function<void(T &)> &fn);
+
+  // Corre hasta que la fuente se agote y todos los tokens terminen.
+  // Bloquea: no llamarlo desde un worker del mismo pool (como wait()).
+  // Si una etapa tira, se deja de leer y run() relanza la primera excepcion
+  void run();
+
+private:
+  typedef struct token
+  {
+    T item;
+    size_t seq; // orden en que lo lleno la fuente
+  } token_t;
+
+  typedef struct stage
+  {
+    stage_mode mode;
+    function<void(T &)> fn;
+    bool busy = false;              // solo etapas seriales
+    size_t nextSeq = 0;             // proximo turno en kStageSerialInOrder
+    map<size_t, token_t *> parked;  // tokens esperando esta etapa, por seq
+  } stage_t;
+
+  void feed(token_t *t);
+  token_t *process(token_t *t, size_t from, bool owned);
+  token_t *release(stage_t &s);
+  token_t *recycle(token_t *t);
+  void fail();
+
+  ThreadPool &pool;
+  function<bool(T &)> sourceFn;
+  vector<stage_t> stages;
+  vector<token_t> tokens;
+
+  mutex lock; // protege todo lo de abajo y el estado de las etapas
+  condition_variable finished;
+  vector<token_t *> freeTokens;
+  bool sourceBusy;
+  bool exhausted;  // la fuente no da mas (o se corto por un error)
+  size_t inFlight; // tokens leidos que no terminaron
+  size_t nextSeq;
+  exception_ptr error;
+  atomic<bool> failed; // hay error: los tokens pasan sin correr las etapas
+
+  Pipeline(const Pipeline &original) = delete;
+  Pipeline &operator=(const Pipeline &rhs) = delete;
+};
+
+template <typename T>
+Pipeline<T>::Pipeline(ThreadPool &pool, size_t maxTokens) : pool(pool),
+                                                            tokens(maxTokens),
+                                                            sourceBusy(false),
+                                                            exhausted(false),
+                                                            inFlight(0),
+                                                            nextSeq(0),
+                                                            failed(false)
+{
+  if (maxTokens == 0)
+  {
+    throw invalid_argument("Pipeline needs at least one token");
+  }
+}
+
+template <typename T>
+Pipeline<T> &Pipeline<T>::source(const function<bool(T &)> &fn)
+{
+  if (!fn)
+  {
+    throw invalid_argument("Cannot use null function as pipeline source");
+  }
+  sourceFn = fn;
+  return *this;
+}
+
+template <typename T>
+Pipeline<T> &Pipeline<T>::stage(stage_mode mode, const function<void(T &)> &fn)
+{
+  if (!fn)
+  {
+    throw invalid_argument("Cannot add null function as pipeline stage");
+  }
+  stages.push_back(stage_t());
+  stages.back().mode = mode;
+  stages.back().fn = fn;
+  return *this;
+}
+
+template <typename T>
+void Pipeline<T>::run()
+{
+  if (!sourceFn)
+  {
+    throw invalid_argument("Pipeline has no source");
+  }
+
+  {
+    lock_guard<mutex> lg(lock);
+    freeTokens.clear();
+    for (size_t i = 1; i < tokens.size(); ++i)
+      freeTokens.push_back(&tokens[i]);
+    for (auto &s : stages)
+    {
+      s.busy = false;
+      s.nextSeq = 0;
+      s.parked.clear();
+    }
+    sourceBusy = true; // el primer token arranca con la fuente tomada
+    exhausted = false;
+    inFlight = 0;
+    nextSeq = 0;
+    error = nullptr;
+    failed = false;
+  }
+
+  token_t *first = &tokens[0];
+  pool.schedule([this, first]()
+                { feed(first); });
+
+  unique_lock<mutex> ul(lock);
+  finished.wait(ul, [this]()
+                { return exhausted && inFlight == 0 && !sourceBusy; });
+  if (error)
+    rethrow_exception(error);
+}
+
+// Llamar con la fuente tomada. Lee un item en t y lo lleva por las etapas
+template <typename T>
+void Pipeline<T>::feed(token_t *t)
+{
+  while (t)
+  {
+    bool got = false;
+    try
+    {
+      got = !failed.load(memory_order_relaxed) && sourceFn(t->item);
+    }
+    catch (...)
+    {
+      fail();
+    }
+
+    token_t *next = nullptr;
+    {
+      lock_guard<mutex> lg(lock);
+      if (!got)
+      {
+        exhausted = true;
+        sourceBusy = false;
+        freeTokens.push_back(t);
+        if (inFlight == 0)
+          finished.notify_all();
+        return;
+      }
+      t->seq = nextSeq++;
+      inFlight++;
+
+      // Si hay otro slot libre, otra task ya puede ir leyendo el siguiente
+      if (!freeTokens.empty())
+      {
+        next = freeTokens.back();
+        freeTokens.pop_back();
+      }
+      else
+      {
+        sourceBusy = false;
+      }
+    }
+
+    if (next)
+    {
+      pool.schedule([this, next]()
+                    { feed(next); });
+    }
+    t = process(t, 0, false);
+  }
+}
+
+// Lleva t por las etapas desde from; owned = ya tiene tomada la etapa from.
+// Devuelve t si termino y hay que volver a llenarlo (con la fuente tomada)
+template <typename T>
+typename Pipeline<T>::token_t *Pipeline<T>::process(token_t *t, size_t from, bool owned)
+{
+  for (size_t i = from; i < stages.size(); ++i)
+  {
+    stage_t &s = stages[i];
+    bool serial = s.mode != kStageParallel;
+    if (serial && !(owned && i == from))
+    {
+      lock_guard<mutex> lg(lock);
+      if (s.busy || (s.mode == kStageSerialInOrder && t->seq != s.nextSeq))
+      {
+        s.parked[t->seq] = t; // lo sigue el que libere la etapa
+        return nullptr;
+      }
+      s.busy = true;
+    }
+
+    // Despues de un error los tokens siguen pasando (pa' no trabar los
+    // turnos de las etapas en orden) pero sin correr nada
+    if (!failed.load(memory_order_relaxed))
+    {
+      try
+      {
+        s.fn(t->item);
+      }
+      catch (...)
+      {
+        fail();
+      }
+    }
+
+    if (serial)
+    {
+      token_t *waiting;
+      {
+        lock_guard<mutex> lg(lock);
+        waiting = release(s);
+      }
+      if (waiting)
+      {
+        pool.schedule([this, waiting, i]()
+                      {
+            token_t *refill = process(waiting, i, true);
+            if (refill)
+                feed(refill); });
+      }
+    }
+  }
+  return recycle(t);
+}
+
+// Con lock tomado: libera la etapa y se la pasa al token estacionado que le toca
+template <typename T>
+typename Pipeline<T>::token_t *Pipeline<T>::release(stage_t &s)
+{
+  s.busy = false;
+  s.nextSeq++;
+  if (s.parked.empty())
+    return nullptr;
+
+  auto it = s.parked.begin();
+  if (s.mode == kStageSerialInOrder && it->first != s.nextSeq)
+    return nullptr; // el que le toca todavia no llego
+  token_t *t = it->second;
+  s.parked.erase(it);
+  s.busy = true;
+  return t;
+}
+
+template <typename T>
+void Pipeline<T>::fail()
+{
+  lock_guard<mutex> lg(lock);
+  if (!error)
+    error = current_exception();
+  failed = true;
+  exhausted = true; // no se leen mas tokens
+}
+
+// El token paso por todas las etapas: si la fuente esta libre se la queda
+// (y lo volvemos a llenar en este mismo worker), si no vuelve a los libres
+template <typename T>
+typename Pipeline<T>::token_t *Pipeline<T>::recycle(token_t *t)
+{
+  lock_guard<mutex> lg(lock);
+  inFlight--;
+  if (!exhausted && !sourceBusy)
+  {
+    sourceBusy = true;
+    return t;
+  }
+  freeTokens.push_back(t);
+  if (exhausted && inFlight == 0 && !sourceBusy)
+    finished.notify_all();
+  return nullptr;
+}
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef _pool_policies_
+#define _pool_policies_
+
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "Semaphore.h"
+#include "job-queue.h"
+#include "mpsc-queue.h"
+
+using namespace std;
+
+// Politicas de BasicThreadPool. Cada una es un tipo chico con funciones
+// inline, asi cada combinacion compila su propio camino caliente sin
+// virtuales ni ifs en runtime.
+
+// Pausa corta dentro de un spin
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  this_thread::yield();
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// QueuePolicy: la cola compartida entre productores y el dispatcher.
+// Interfaz: push(node), pushChain(JobQueue &), pop() -> node o nullptr, size()
+// y kBounded (si la capacidad limita a los productores)
+
+// La de siempre: JobQueue protegida por un mutex
+class MutexQueue
+{
+public:
+  static constexpr bool kBounded = false;
+
+  void push(job_node_t *node)
+  {
+    lock_guard<mutex> lg(lock);
+    q.push(node);
+  }
+
+  void pushChain(JobQueue &chain)
+  {
+    lock_guard<mutex> lg(lock);
+    q.splice(chain);
+  }
+
+  job_node_t *pop()
+  {
+    lock_guard<mutex> lg(lock);
+    return q.pop();
+  }
+
+  size_t size()
+  {
+    lock_guard<mutex> lg(lock);
+    return q.size();
+  }
+
+private:
+  mutex lock;
+  JobQueue q;
+};
+
+// MPSC lock-free (Vyukov) sobre los mismos nodos. Los productores empujan
+// con un exchange; el unico que saca es el dispatcher
+class LockFreeQueue
+{
+public:
+  static constexpr bool kBounded = false;
+
+  LockFreeQueue() : count(0) {}
+
+  void push(job_node_t *node)
+  {
+    count.fetch_add(1, memory_order_relaxed);
+    q.push(node);
+  }
+
+  void pushChain(JobQueue &chain)
+  {
+    while (job_node_t *node = chain.pop())
+      push(node);
+  }
+
+  job_node_t *pop()
+  {
+    job_node_t *node = q.pop();
+    if (node)
+    {
+      count.fetch_sub(1, memory_order_relaxed);
+      node->next.store(nullptr, memory_order_relaxed);
+    }
+    return node;
+  }
+
+  size_t size() { return count.load(memory_order_relaxed); }
+
+private:
+  MpscQueue<job_node_t> q;
+  atomic<size_t> count;
+};
+
+// Cola acotada: con Capacity tasks en cola schedule() se bloquea hasta que
+// el dispatcher saque alguna (backpressure). Un lote de producer buffers
+// entra entero aunque se pase un poco del limite. El dispatcher no arma
+// lotes con esta cola: sacarlos de a muchos vaciaria el limite
+template <size_t Capacity>
+class BoundedQueue
+{
+public:
+  static constexpr bool kBounded = true;
+
+  void push(job_node_t *node)
+  {
+    unique_lock<mutex> ul(lock);
+    notFull.wait(ul, [this]()
+                 { return q.size() < Capacity; });
+    q.push(node);
+  }
+
+  void pushChain(JobQueue &chain)
+  {
+    unique_lock<mutex> ul(lock);
+    notFull.wait(ul, [this]()
+                 { return q.size() < Capacity; });
+    q.splice(chain);
+  }
+
+  job_node_t *pop()
+  {
+    lock_guard<mutex> lg(lock);
+    job_node_t *node = q.pop();
+    if (node)
+      notFull.notify_one();
+    return node;
+  }
+
+  size_t size()
+  {
+    lock_guard<mutex> lg(lock);
+    return q.size();
+  }
+
+private:
+  mutex lock;
+  condition_variable notFull;
+  JobQueue q;
+};
+
+// ---------------------------------------------------------------------------
+// WaitPolicy: como se queda esperando un hilo ocioso (workers y dispatcher)
+
+// Dormir en el semaforo directamente
+struct BlockingWait
+{
+  static void idle(Semaphore &s) { s.wait(); }
+};
+
+// Girar un rato antes de dormir: menos latencia de despertar, mas CPU
+struct SpinWait
+{
+  static void idle(Semaphore &s)
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      if (s.tryWait())
+        return;
+      for (int k = 0; k < 16; k++)
+        cpuRelax();
+    }
+    s.wait();
+  }
+};
+
+// ---------------------------------------------------------------------------
+// StatsPolicy: hooks que el pool llama en el camino caliente
+
+// Sin metricas: todo vacio, el compilador lo borra
+struct NoStats
+{
+  void onSchedule() {}
+  void onComplete() {}
+  void onSkip() {}
+  void onReject() {}
+  void onInline() {}
+};
+
+// Contadores atomicos relajados
+struct CountingStats
+{
+  atomic<size_t> scheduled{0};
+  atomic<size_t> completed{0};
+  atomic<size_t> skipped{0};  // canceladas antes de correr
+  atomic<size_t> rejected{0}; // trySchedule rechazadas por sobrecarga
+  atomic<size_t> inlined{0};  // corridas en el hilo que las programo por saturacion
+
+  void onSchedule() { scheduled.fetch_add(1, memory_order_relaxed); }
+  void onComplete() { completed.fetch_add(1, memory_order_relaxed); }
+  void onSkip() { skipped.fetch_add(1, memory_order_relaxed); }
+  void onReject() { rejected.fetch_add(1, memory_order_relaxed); }
+  void onInline() { inlined.fetch_add(1, memory_order_relaxed); }
+};
+
+#endif
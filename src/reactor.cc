@@ -0,0 +1,171 @@
+#include "reactor.h"
+#include <stdexcept>
+#include <system_error>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/eventfd.h>
+using namespace std;
+
+static const int kMaxEvents = 64;
+
+Reactor::state::~state()
+{
+    if (epfd >= 0)
+        close(epfd);
+    if (wakefd >= 0)
+        close(wakefd);
+}
+
+Reactor::Reactor(ThreadPool &pool) : pool(pool),
+                                     st(make_shared<state>()),
+                                     done(false)
+{
+    st->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (st->epfd < 0)
+    {
+        throw system_error(errno, generic_category(), "epoll_create1");
+    }
+    st->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (st->wakefd < 0)
+    {
+        throw system_error(errno, generic_category(), "eventfd");
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = st->wakefd;
+    if (epoll_ctl(st->epfd, EPOLL_CTL_ADD, st->wakefd, &ev) < 0)
+    {
+        throw system_error(errno, generic_category(), "epoll_ctl");
+    }
+
+    rt = thread(&Reactor::loop, this);
+}
+
+void Reactor::add(int fd, uint32_t events, const function<void(uint32_t)> &callback)
+{
+    if (!callback)
+    {
+        throw invalid_argument("Cannot watch fd with null callback");
+    }
+
+    auto w = make_shared<watch_t>();
+    w->fd = fd;
+    w->events = events;
+    w->callback = callback;
+    w->active = true;
+
+    lock_guard<mutex> lg(st->lock);
+    if (st->closed)
+    {
+        throw runtime_error("Cannot add fd to destroyed Reactor");
+    }
+    if (st->watches.count(fd))
+    {
+        throw invalid_argument("fd already registered in Reactor");
+    }
+
+    epoll_event ev{};
+    ev.events = events | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (epoll_ctl(st->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+        throw system_error(errno, generic_category(), "epoll_ctl");
+    }
+    st->watches[fd] = w;
+}
+
+void Reactor::remove(int fd)
+{
+    lock_guard<mutex> lg(st->lock);
+    auto it = st->watches.find(fd);
+    if (it == st->watches.end())
+        return;
+
+    it->second->active = false;
+    epoll_ctl(st->epfd, EPOLL_CTL_DEL, fd, nullptr); // si ya lo cerraron no pasa nada
+    st->watches.erase(it);
+}
+
+void Reactor::rearm(const shared_ptr<state> &st, const shared_ptr<watch_t> &w)
+{
+    lock_guard<mutex> lg(st->lock);
+    if (st->closed || !w->active)
+        return;
+
+    epoll_event ev{};
+    ev.events = w->events | EPOLLONESHOT;
+    ev.data.fd = w->fd;
+    epoll_ctl(st->epfd, EPOLL_CTL_MOD, w->fd, &ev);
+}
+
+void Reactor::loop()
+{
+    epoll_event events[kMaxEvents];
+
+    while (!done)
+    {
+        int n = epoll_wait(st->epfd, events, kMaxEvents, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            int fd = events[i].data.fd;
+            uint32_t ready = events[i].events;
+            if (fd == st->wakefd)
+                continue; // nos estan cerrando
+
+            shared_ptr<watch_t> w;
+            {
+                lock_guard<mutex> lg(st->lock);
+                auto it = st->watches.find(fd);
+                if (it == st->watches.end())
+                    continue; // lo sacaron mientras esperabamos
+                w = it->second;
+            }
+
+            // El callback va al pool; al terminar se rearma el fd
+            shared_ptr<state> shared = st;
+            try
+            {
+                pool.schedule([shared, w, ready]()
+                              {
+                    w->callback(ready);
+                    rearm(shared, w); });
+            }
+            catch (const runtime_error &)
+            {
+                return; // el pool ya no acepta tasks
+            }
+        }
+    }
+}
+
+Reactor::~Reactor()
+{
+    done = true;
+
+    // Despertar al reactor del epoll_wait
+    uint64_t one = 1;
+    ssize_t ignored = write(st->wakefd, &one, sizeof(one));
+    (void)ignored;
+
+    if (rt.joinable())
+    {
+        rt.join();
+    }
+
+    // Los callbacks que siguen en el pool ya no rearman nada
+    lock_guard<mutex> lg(st->lock);
+    st->closed = true;
+    for (auto &entry : st->watches)
+    {
+        entry.second->active = false;
+    }
+    st->watches.clear();
+}
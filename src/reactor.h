@@ -0,0 +1,68 @@
+#ifndef _reactor_
+#define _reactor_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <sys/epoll.h>
+#include "thread-pool.h"
+
+using namespace std;
+
+// Un fd registrado y lo que hay que correr cuando esta listo
+typedef struct watch
+{
+  int fd;
+  uint32_t events;
+  function<void(uint32_t)> callback; // recibe los eventos que llegaron
+  bool active;                       // false despues de remove()
+} watch_t;
+
+// Hilo reactor al lado del ThreadPool: espera readiness con epoll y
+// manda el callback al pool, asi ningun worker se queda bloqueado en un read.
+// Los fds se arman con EPOLLONESHOT y se rearman cuando el callback termina,
+// entonces nunca hay dos callbacks del mismo fd corriendo a la vez.
+class Reactor
+{
+public:
+  // Arranca el hilo del reactor; los callbacks corren en el pool
+  Reactor(ThreadPool &pool);
+
+  // Registra un fd (EPOLLIN, EPOLLOUT, ...) con su callback
+  void add(int fd, uint32_t events, const function<void(uint32_t)> &callback);
+
+  // Deja de vigilar el fd; un callback que ya estaba en el pool puede terminar
+  void remove(int fd);
+
+  // Frena el hilo y suelta el epoll, los fds siguen siendo del que llama
+  ~Reactor();
+
+private:
+  // Estado compartido con los callbacks que siguen en el pool
+  struct state
+  {
+    mutex lock;
+    int epfd = -1;
+    int wakefd = -1; // eventfd pa' despertar epoll_wait al cerrar
+    bool closed = false;
+    unordered_map<int, shared_ptr<watch_t>> watches;
+    ~state();
+  };
+
+  void loop();
+  static void rearm(const shared_ptr<state> &st, const shared_ptr<watch_t> &w);
+
+  ThreadPool &pool;
+  shared_ptr<state> st;
+  thread rt; // hilo reactor
+  atomic<bool> done;
+
+  Reactor(const Reactor &original) = delete;
+  Reactor &operator=(const Reactor &rhs) = delete;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "shared-pool.h"
+#include <stdexcept>
+#include <thread>
+using namespace std;
+
+ThreadPool &defaultPool()
+{
+    // Un worker por core pa' todo el proceso; como arranca lazy, si nadie
+    // programa nada no se crea ningun hilo
+    static ThreadPool pool(max(1u, thread::hardware_concurrency()));
+    return pool;
+}
+
+PoolFacade::PoolFacade(size_t maxConcurrency, ThreadPool &pool) : pool(pool),
+                                                                   limit(maxConcurrency),
+                                                                   running(0),
+                                                                   outstanding(0),
+                                                                   completed(0)
+{
+}
+
+void PoolFacade::schedule(const function<void(void)> &thunk)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot schedule null function");
+    }
+
+    {
+        lock_guard<mutex> lg(lock);
+        outstanding++;
+        if (limit != 0 && running >= limit)
+        {
+            held.push(thunk); // sale cuando termine alguna de las que corren
+            return;
+        }
+        running++;
+    }
+    submit(thunk);
+}
+
+void PoolFacade::submit(const function<void(void)> &thunk)
+{
+    pool.schedule([this, thunk]()
+                  {
+        thunk();
+        taskDone(); });
+}
+
+void PoolFacade::taskDone()
+{
+    function<void(void)> next;
+    {
+        lock_guard<mutex> lg(lock);
+        completed++;
+        outstanding--;
+        if (!held.empty())
+        {
+            next = move(held.front()); // hereda el lugar de la que termino
+            held.pop();
+        }
+        else
+        {
+            running--;
+        }
+        if (outstanding == 0)
+            allDone.notify_all();
+    }
+
+    if (next)
+        submit(next);
+}
+
+void PoolFacade::wait()
+{
+    unique_lock<mutex> ul(lock);
+    allDone.wait(ul, [this]()
+                 { return outstanding == 0; });
+}
+
+size_t PoolFacade::pendingTasks()
+{
+    lock_guard<mutex> lg(lock);
+    return outstanding;
+}
+
+PoolFacade::~PoolFacade()
+{
+    wait();
+}
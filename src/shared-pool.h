@@ -0,0 +1,57 @@
+#ifndef _shared_pool_
+#define _shared_pool_
+
+#include <cstddef>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include "thread-pool.h"
+
+using namespace std;
+
+// Pool por defecto de todo el proceso, con un hilo por core. Se crea la
+// primera vez que alguien lo pide y las librerias lo comparten en vez de
+// armarse cada una su ThreadPool(n)
+ThreadPool &defaultPool();
+
+// Fachada sobre un pool compartido: usa sus workers pero tiene su propio
+// wait(), sus metricas y un limite opcional de tasks corriendo a la vez
+class PoolFacade
+{
+public:
+  // maxConcurrency = 0 es sin limite (el del pool de abajo)
+  PoolFacade(size_t maxConcurrency = 0, ThreadPool &pool = defaultPool());
+
+  // Programa una task en el pool compartido (o la retiene si se llego al limite)
+  void schedule(const function<void(void)> &thunk);
+
+  // Espera solo las tasks de esta fachada
+  void wait();
+
+  // Metricas de esta fachada
+  size_t completedTasks() const { return completed.load(); }
+  size_t pendingTasks();
+
+  // Espera lo suyo antes de irse, igual que ~ThreadPool()
+  ~PoolFacade();
+
+private:
+  void submit(const function<void(void)> &thunk);
+  void taskDone();
+
+  ThreadPool &pool;
+  size_t limit;
+  mutex lock;
+  condition_variable allDone;
+  queue<function<void(void)>> held; // esperando por el limite de concurrencia
+  size_t running;                   // ya entregadas al pool
+  size_t outstanding;               // programadas y sin terminar
+  atomic<size_t> completed;
+
+  PoolFacade(const PoolFacade &original) = delete;
+  PoolFacade &operator=(const PoolFacade &rhs) = delete;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "strand.h"
+#include <stdexcept>
+#include <thread>
+using namespace std;
+
+// Cuantas tasks corre una activacion antes de devolverle el worker al pool
+static const size_t kMaxBatch = 64;
+
+Strand::Strand(ThreadPool &pool) : pool(pool),
+                                   pending(0) {}
+
+void Strand::post(const function<void(void)> &thunk)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot post null function");
+    }
+
+    node *n = new node;
+    n->thunk = thunk;
+    queue.push(n);
+
+    // El que pasa pending de 0 a 1 es el que activa el strand
+    if (pending.fetch_add(1, memory_order_acq_rel) == 0)
+    {
+        pool.schedule([this]()
+                      { run(); });
+    }
+}
+
+void Strand::run()
+{
+    for (size_t i = 0; i < kMaxBatch; i++)
+    {
+        node *n = queue.pop();
+        while (!n)
+        {
+            // pending dice que hay algo pero el push todavia no termino de enlazar
+            this_thread::yield();
+            n = queue.pop();
+        }
+
+        n->thunk();
+        delete n;
+
+        if (pending.fetch_sub(1, memory_order_acq_rel) == 1)
+            return; // no queda nada, la proxima post() nos reactiva
+    }
+
+    // Quedan tasks: seguir en otra activacion pa' no acaparar el worker
+    pool.schedule([this]()
+                  { run(); });
+}
+
+Strand::~Strand()
+{
+    node *n;
+    while ((n = queue.pop()) != nullptr)
+    {
+        delete n;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef _strand_
+#define _strand_
+
+#include <functional>
+#include <atomic>
+#include <memory>
+#include "thread-pool.h"
+#include "mpsc-queue.h"
+
+using namespace std;
+
+// Executor serializado arriba del ThreadPool: lo que se postea en un strand
+// corre en orden FIFO y nunca en paralelo, sin mutex adentro de las tasks.
+// Cuando hay trabajo, una sola task del pool (la activacion) drena varias
+// tasks seguidas; ningun worker se queda bloqueado esperando.
+class Strand
+{
+public:
+  Strand(ThreadPool &pool);
+
+  // Encola thunk detras de lo que ya se posteo en este strand
+  void post(const function<void(void)> &thunk);
+
+  // El strand tiene que vivir hasta que el pool termine sus tasks (pool.wait())
+  ~Strand();
+
+private:
+  // Nodo de la cola MPSC: push con un exchange, pop sin atomicos caros
+  struct node
+  {
+    atomic<node *> next;
+    function<void(void)> thunk;
+  };
+
+  void run();
+
+  ThreadPool &pool;
+  MpscQueue<node> queue;   // pop() solo desde la activacion en curso
+  atomic<size_t> pending;  // posteadas y no ejecutadas; > 0 = hay una activacion en el pool
+
+  Strand(const Strand &original) = delete;
+  Strand &operator=(const Strand &rhs) = delete;
+};
+
+#endif
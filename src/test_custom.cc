@@ -10,6 +10,16 @@
 #endif
 
 #include "thread-pool.h"
+#include "coro-task.h"
+#include "reactor.h"
+#include "strand.h"
+#include "shared-pool.h"
+#include "parallel-sort.h"
+#include "parallel-scan.h"
+#include "pipeline.h"
+#include "channel.h"
+#include "worker-local.h"
+#include "executor.h"
 #include <iostream>
 #include <vector>
 #include <thread>
@@ -22,9 +32,15 @@
 #include <future>
 #include <sys/wait.h> // waitpid
 #include <unistd.h>   // fork
+#include <sys/eventfd.h>
+#include <sys/socket.h>
 #include <map>
 #include <algorithm>
 #include <array>
+#include <set>
+#include <cstdlib>
+#include <new>
+#include <numeric>
 
 using namespace std;
 using namespace chrono;
@@ -32,6 +48,28 @@ using namespace chrono;
 mutex oslock;
 bool global_success = true;
 
+// ---------------------------------------------------------------------------
+// Contador de allocs: reemplaza el operator new global del binario de tests
+static atomic<size_t> allocCount{0};
+
+void *operator new(size_t size)
+{
+    allocCount.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
 // ---------------------------------------------------------------------------
 void sleep_for_ms(int ms)
 {
@@ -781,42 +819,58 @@ bool test_concurrent_schedule_wait_parallel()
     }
 }
 
-// ---------------------------------------------------------------------------
-// Lifecycle (L): pruebas de ciclo de vida del pool
-// ---------------------------------------------------------------------------
+task<int> coro_hop(ThreadPool &pool, thread::id caller)
+{
+    co_await pool.schedule(); // de aca en adelante corre en un worker
+    co_return this_thread::get_id() != caller ? 1 : 0;
+}
 
-bool test_destructor_waits_for_tasks()
+task<int> coro_sum_hops(ThreadPool &pool, thread::id caller, int hops)
 {
-    auto start = high_resolution_clock::now();
+    int total = 0;
+    for (int i = 0; i < hops; ++i)
     {
-        ThreadPool pool(1);
-        pool.schedule([]()
-                      { sleep_for_ms(100); });
-    } // Destructor acá
-    auto end = high_resolution_clock::now();
-    auto ms = duration_cast<milliseconds>(end - start).count();
-    return ms >= 100;
+        total += co_await coro_hop(pool, caller);
+    }
+    co_return total;
 }
 
-bool test_repeated_pool_creation()
+task<void> coro_throws(ThreadPool &pool)
+{
+    co_await pool.schedule();
+    throw runtime_error("boom");
+}
+
+bool test_coroutine_schedule()
 {
     try
     {
-        const int rounds = 100;
-        for (int r = 0; r < rounds; ++r)
+        ThreadPool pool(4);
+        int hops = sync_wait(coro_sum_hops(pool, this_thread::get_id(), 200));
+        pool.wait();
+        return hops == 200;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_coroutine_exception_propagation()
+{
+    try
+    {
+        ThreadPool pool(2);
+        try
+        {
+            sync_wait(coro_throws(pool));
+            return false;
+        }
+        catch (const runtime_error &e)
         {
-            ThreadPool pool(2);
-            atomic<int> counter{0};
-            for (int i = 0; i < 10; ++i)
-            {
-                pool.schedule([&]()
-                              { counter.fetch_add(1, memory_order_relaxed); });
-            }
             pool.wait();
-            if (counter != 10)
-                return false;
+            return string(e.what()) == "boom";
         }
-        return true;
     }
     catch (...)
     {
@@ -824,98 +878,1883 @@ bool test_repeated_pool_creation()
     }
 }
 
-// ---------------------------------------------------------------------------
-// Nesting (N): scheduling anidado profundo
-// ---------------------------------------------------------------------------
+bool test_reactor_pipe_readiness()
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+        return false;
 
-bool test_deep_nested_scheduling()
+    bool ok = false;
+    try
+    {
+        ThreadPool pool(2);
+        Reactor reactor(pool);
+        promise<string> prom;
+        auto fut = prom.get_future();
+        atomic<bool> delivered{false};
+
+        reactor.add(fds[0], EPOLLIN, [&](uint32_t events)
+                    {
+            char buf[16] = {0};
+            ssize_t n = read(fds[0], buf, sizeof(buf) - 1);
+            if ((events & EPOLLIN) && n > 0 && !delivered.exchange(true))
+                prom.set_value(string(buf, n)); });
+
+        if (write(fds[1], "hola", 4) != 4)
+            return false;
+
+        ok = fut.wait_for(milliseconds(1000)) == future_status::ready && fut.get() == "hola";
+        reactor.remove(fds[0]);
+        pool.wait();
+    }
+    catch (...)
+    {
+        ok = false;
+    }
+    close(fds[0]);
+    close(fds[1]);
+    return ok;
+}
+
+bool test_reactor_many_sockets_few_workers()
 {
-    promise<bool> prom;
-    auto fut = prom.get_future();
+    const int connections = 500;
+    vector<array<int, 2>> pairs(connections);
+    for (auto &p : pairs)
+    {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, p.data()) != 0)
+            return false;
+    }
 
-    thread t([&prom]()
-             {
-        try {
-            ThreadPool pool(4);
-            atomic<int> count(0);
-            pool.schedule([&]() {
-                count++;
-                pool.schedule([&]() {
-                    count++;
-                    pool.schedule([&]() {
-                        count++;
-                    });
-                });
-            });
-            pool.wait();
-            prom.set_value(count == 3);
-        } catch (...) {
-            prom.set_value(false);
-        } });
+    bool ok = false;
+    try
+    {
+        ThreadPool pool(2);
+        Reactor reactor(pool);
+        atomic<int> served{0};
 
-    t.join();         // espera que el hilo termine antes de usar el future
-    return fut.get(); // seguro: no hay acceso concurrente al shared state
+        for (auto &p : pairs)
+        {
+            int fd = p[0];
+            reactor.add(fd, EPOLLIN, [fd, &served](uint32_t)
+                        {
+                char c;
+                if (read(fd, &c, 1) == 1 && c == 'x')
+                    served.fetch_add(1); });
+        }
+        for (auto &p : pairs)
+        {
+            if (write(p[1], "x", 1) != 1)
+                return false;
+        }
+
+        auto deadline = steady_clock::now() + milliseconds(2000);
+        while (served < connections && steady_clock::now() < deadline)
+            sleep_for_ms(1);
+        ok = served == connections;
+
+        for (auto &p : pairs)
+            reactor.remove(p[0]);
+        pool.wait();
+    }
+    catch (...)
+    {
+        ok = false;
+    }
+    for (auto &p : pairs)
+    {
+        close(p[0]);
+        close(p[1]);
+    }
+    return ok;
 }
 
-bool test_extreme_nested_scheduling()
+bool test_reactor_remove_stops_callbacks()
 {
-    const int depth = 1000;
-    const int timeout_ms = 2000;
+    int efd = eventfd(0, EFD_NONBLOCK);
+    if (efd < 0)
+        return false;
 
-    promise<bool> prom;
-    auto fut = prom.get_future();
+    bool ok = false;
+    try
+    {
+        ThreadPool pool(2);
+        Reactor reactor(pool);
+        atomic<int> fired{0};
 
-    thread t([&prom, depth, timeout_ms]()
-             {
-        try {
-            ThreadPool pool(4);
-            atomic<int> leafCount{0};
+        reactor.add(efd, EPOLLIN, [efd, &fired](uint32_t)
+                    {
+            uint64_t v;
+            if (read(efd, &v, sizeof(v)) == sizeof(v))
+                fired.fetch_add(1); });
 
-            function<void(int)> scheduleDepth = [&](int d) {
-                if (d == 0) {
-                    leafCount.fetch_add(1, memory_order_relaxed);
-                    return;
-                }
-                pool.schedule([&, d]() {
-                    scheduleDepth(d - 1);
-                });
-            };
+        uint64_t one = 1;
+        if (write(efd, &one, sizeof(one)) != sizeof(one))
+            return false;
+        auto deadline = steady_clock::now() + milliseconds(1000);
+        while (fired == 0 && steady_clock::now() < deadline)
+            sleep_for_ms(1);
+        pool.wait();
 
-            auto start = chrono::steady_clock::now();
-            scheduleDepth(depth);
-            pool.wait();
-            auto end = chrono::steady_clock::now();
+        reactor.remove(efd);
+        if (write(efd, &one, sizeof(one)) != sizeof(one))
+            return false;
+        sleep_for_ms(50);
+        pool.wait();
+        ok = fired == 1;
+    }
+    catch (...)
+    {
+        ok = false;
+    }
+    close(efd);
+    return ok;
+}
 
-            auto elapsed = chrono::duration_cast<chrono::milliseconds>(end - start).count();
-            prom.set_value((elapsed <= timeout_ms) && (leafCount == 1));
-        } catch (...) {
-            prom.set_value(false);
-        } });
+bool test_cancel_pending_tasks()
+{
+    try
+    {
+        ThreadPool pool(1);
+        CancellationToken token;
+        atomic<int> executed{0};
 
-    t.join();         // asegura que set_value ya ocurrió
-    return fut.get(); // ahora es seguro
+        pool.schedule([]()
+                      { sleep_for_ms(50); }); // ocupa al unico worker
+        for (int i = 0; i < 1000; ++i)
+        {
+            pool.schedule([&]()
+                          { executed++; },
+                          token);
+        }
+        token.cancel();
+        pool.wait();
+
+        // Despues de cancelar el pool sigue andando normal
+        pool.schedule([&]()
+                      { executed += 1000; });
+        pool.wait();
+        return executed == 1000;
+    }
+    catch (...)
+    {
+        return false;
+    }
 }
 
-// ---------------------------------------------------------------------------
-// Timing (T): mediciones de paralelismo
-// ---------------------------------------------------------------------------
+bool test_cancel_running_task_polls_token()
+{
+    try
+    {
+        ThreadPool pool(2);
+        CancellationToken token;
+        atomic<bool> started{false};
 
-bool test_parallel_speedup()
+        pool.schedule([&, token]()
+                      {
+            started = true;
+            while (!token.isCancelled())
+                this_thread::yield(); },
+                      token);
+
+        while (!started)
+            this_thread::yield();
+        token.cancel();
+        pool.wait(); // termina porque la task mira el token
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_producer_buffers_concurrent()
 {
-    const int tasks = 4;
-    const int sleep_ms = 100;
-    ThreadPool pool(tasks);
-    auto t0 = high_resolution_clock::now();
-    for (int i = 0; i < tasks; ++i)
+    try
     {
-        pool.schedule([=]()
-                      { sleep_for_ms(sleep_ms); });
+        ThreadPool pool(4);
+        pool.enableProducerBuffers(16, chrono::milliseconds(2));
+        atomic<int> executed{0};
+
+        vector<thread> producers;
+        for (int p = 0; p < 4; ++p)
+        {
+            producers.emplace_back([&]()
+                                   {
+                for (int i = 0; i < 250; ++i)
+                    pool.schedule([&]() { executed.fetch_add(1, memory_order_relaxed); }); });
+        }
+        for (auto &t : producers)
+            t.join();
+
+        pool.wait(); // tiene que ver lo que quedo en los buffers
+        return executed == 1000;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_producer_buffers_latency_bound()
+{
+    try
+    {
+        ThreadPool pool(2);
+        pool.enableProducerBuffers(1000, chrono::milliseconds(5));
+        atomic<bool> ran{false};
+
+        // Un lote que nunca se llena igual tiene que salir por tiempo
+        pool.schedule([&]()
+                      { ran = true; });
+        auto deadline = steady_clock::now() + milliseconds(500);
+        while (!ran && steady_clock::now() < deadline)
+            sleep_for_ms(1);
+        bool onTime = ran;
+
+        pool.schedule([&]()
+                      { ran = false; });
+        pool.flush();
+        pool.wait();
+        return onTime && !ran;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_producer_buffers_forget_dead_pools()
+{
+    try
+    {
+        // Un productor que vive mucho y pasa por muchos pools cortos
+        atomic<int> ran{0};
+        for (int i = 0; i < 200; ++i)
+        {
+            ThreadPool pool(1);
+            pool.enableProducerBuffers(8, chrono::milliseconds(1));
+            pool.schedule([&ran]()
+                          { ran++; });
+            pool.wait();
+        }
+        return ran == 200 && pool_detail::localBuffers.size() <= 1;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_steady_state_no_allocations()
+{
+    try
+    {
+        ThreadPool pool(4);
+        atomic<int> counter{0};
+        auto round = [&]()
+        {
+            for (int i = 0; i < 100; ++i)
+                pool.schedule([&counter]()
+                              { counter.fetch_add(1, memory_order_relaxed); });
+            pool.wait();
+        };
+
+        for (int r = 0; r < 20; ++r)
+            round(); // calentar slabs y caches de nodos
+
+        size_t before = allocCount.load();
+        for (int r = 0; r < 100; ++r)
+            round();
+        size_t after = allocCount.load();
+
+        // Capturas que no entran en el buffer de function (16 bytes) pero si
+        // en el del nodo: tampoco alocan
+        array<uint64_t, 5> payload = {1, 2, 3, 4, 5};
+        atomic<uint64_t> sum{0};
+        auto bigRound = [&]()
+        {
+            for (int i = 0; i < 100; ++i)
+                pool.schedule([&sum, payload]()
+                              { sum.fetch_add(payload[0] + payload[4], memory_order_relaxed); });
+            pool.wait();
+        };
+        for (int r = 0; r < 20; ++r)
+            bigRound();
+        size_t bigBefore = allocCount.load();
+        for (int r = 0; r < 100; ++r)
+            bigRound();
+        size_t bigAfter = allocCount.load();
+
+        return counter == 12000 && after == before && sum == 12000 * 6 && bigAfter == bigBefore;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_invoke_does_not_allocate()
+{
+    try
+    {
+        // Las dos ramas capturan varias referencias (como en parallel_sort):
+        // con function eso eran dos mallocs por fork
+        ThreadPool pool(1);
+        size_t allocs = 0;
+        long total = 0;
+        pool.schedule([&]()
+                      {
+            long a = 0, b = 0, c = 0, d = 0;
+            for (int i = 0; i < 10; ++i) // calentar el deque de forks
+                pool.invoke([&]() { a++; b += c; }, [&]() { c++; d += a; });
+            size_t before = allocCount.load();
+            for (int i = 0; i < 1000; ++i)
+                pool.invoke([&]() { a++; b += c; }, [&]() { c++; d += a; });
+            allocs = allocCount.load() - before;
+            total = a + c; });
+        pool.wait();
+        return allocs == 0 && total == 2020;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_keyed_affinity_same_worker()
+{
+    try
+    {
+        ThreadPool pool(4);
+        const int keys = 8;
+        vector<thread::id> owner(keys);
+        atomic<bool> moved{false};
+
+        for (int round = 0; round < 50; ++round)
+        {
+            for (int k = 0; k < keys; ++k)
+            {
+                pool.scheduleOn(k, [&, k, round]()
+                                {
+                    if (round == 0)
+                        owner[k] = this_thread::get_id();
+                    else if (owner[k] != this_thread::get_id())
+                        moved = true; });
+            }
+            pool.wait();
+        }
+
+        // Sin workers no hay a quien asignarle la clave
+        ThreadPool empty(0);
+        bool threw = false;
+        try
+        {
+            empty.scheduleOn(1, []() {});
+        }
+        catch (const invalid_argument &)
+        {
+            threw = true;
+        }
+        return !moved && threw;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_keyed_affinity_steals_when_overloaded()
+{
+    try
+    {
+        ThreadPool pool(4);
+        mutex mtx;
+        set<thread::id> seen;
+        atomic<int> done{0};
+
+        auto start = steady_clock::now();
+        for (int i = 0; i < 100; ++i)
+        {
+            pool.scheduleOn(42, [&]()
+                            {
+                sleep_for_ms(2);
+                {
+                    lock_guard<mutex> lg(mtx);
+                    seen.insert(this_thread::get_id());
+                }
+                done++; });
+        }
+        pool.wait();
+        auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+        // Todo en un worker serian 200ms; robando se reparte
+        return done == 100 && seen.size() > 1 && elapsed < 150;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_strand_fifo_without_mutex()
+{
+    try
+    {
+        ThreadPool pool(4);
+        Strand strand(pool);
+        vector<int> order;           // sin mutex: el strand serializa
+        atomic<int> inside{0};
+        atomic<bool> overlapped{false};
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            strand.post([&, i]()
+                        {
+                if (inside.fetch_add(1) != 0)
+                    overlapped = true;
+                order.push_back(i);
+                inside.fetch_sub(1); });
+        }
+        pool.wait();
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (order[i] != i)
+                return false;
+        }
+        return !overlapped && order.size() == 1000;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_strand_concurrent_producers()
+{
+    try
+    {
+        ThreadPool pool(4);
+        Strand a(pool), b(pool);
+        vector<int> seqA, seqB;
+        int counterA = 0, counterB = 0;
+
+        vector<thread> producers;
+        for (int p = 0; p < 4; ++p)
+        {
+            producers.emplace_back([&, p]()
+                                   {
+                for (int i = 0; i < 250; ++i) {
+                    a.post([&, p, i]() { counterA++; if (p == 0) seqA.push_back(i); });
+                    b.post([&, p, i]() { counterB++; if (p == 1) seqB.push_back(i); });
+                } });
+        }
+        for (auto &t : producers)
+            t.join();
+        pool.wait();
+
+        // El orden de cada productor se respeta dentro de su strand
+        for (int i = 0; i < 250; ++i)
+        {
+            if (seqA[i] != i || seqB[i] != i)
+                return false;
+        }
+        return counterA == 1000 && counterB == 1000;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_facades_share_default_pool()
+{
+    try
+    {
+        if (&defaultPool() != &defaultPool())
+            return false;
+
+        PoolFacade slow, fast;
+        atomic<int> slowDone{0}, fastDone{0};
+        for (int i = 0; i < 100; ++i)
+            fast.schedule([&]()
+                          { fastDone++; });
+        for (int i = 0; i < 2; ++i)
+            slow.schedule([&]()
+                          { sleep_for_ms(200); slowDone++; });
+
+        // El wait() de una fachada no espera las tasks de la otra
+        fast.wait();
+        bool independent = fastDone == 100 && slowDone == 0;
+        slow.wait();
+        return independent && slowDone == 2 && fast.completedTasks() == 100 &&
+               slow.completedTasks() == 2 && slow.pendingTasks() == 0;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_facade_concurrency_limit()
+{
+    try
+    {
+        ThreadPool pool(8);
+        PoolFacade facade(2, pool);
+        atomic<int> inside{0}, maxInside{0}, executed{0};
+
+        for (int i = 0; i < 50; ++i)
+        {
+            facade.schedule([&]()
+                            {
+                int now = ++inside;
+                int prev = maxInside.load();
+                while (now > prev && !maxInside.compare_exchange_weak(prev, now))
+                    ;
+                sleep_for_ms(1);
+                inside--;
+                executed++; });
+        }
+        facade.wait();
+        return executed == 50 && maxInside <= 2;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_policy_lockfree_spin_counting()
+{
+    try
+    {
+        BasicThreadPool<LockFreeQueue, SpinWait, CountingStats> pool(4);
+        atomic<int> executed{0};
+        CancellationToken token;
+        token.cancel();
+
+        vector<thread> producers;
+        for (int p = 0; p < 4; ++p)
+        {
+            producers.emplace_back([&]()
+                                   {
+                for (int i = 0; i < 2500; ++i)
+                    pool.schedule([&]() { executed.fetch_add(1, memory_order_relaxed); }); });
+        }
+        for (auto &t : producers)
+            t.join();
+        pool.schedule([&]()
+                      { executed += 1000000; },
+                      token);
+        pool.wait();
+
+        const CountingStats &stats = pool.statistics();
+        return executed == 10000 && stats.scheduled == 10001 &&
+               stats.completed == 10000 && stats.skipped == 1;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_policy_bounded_queue_backpressure()
+{
+    try
+    {
+        BasicThreadPool<BoundedQueue<16>, BlockingWait, NoStats> pool(1);
+        atomic<bool> release{false};
+        atomic<int> accepted{0}, executed{0};
+
+        pool.schedule([&]()
+                      {
+            while (!release)
+                sleep_for_ms(1); });
+
+        thread producer([&]()
+                        {
+            for (int i = 0; i < 100; ++i) {
+                pool.schedule([&]() { executed++; });
+                accepted++;
+            } });
+
+        sleep_for_ms(100);
+        // Cola llena (16) + la que el dispatcher tiene en la mano esperando worker
+        int acceptedWhileBlocked = accepted;
+        release = true;
+        producer.join();
+        pool.wait();
+        return acceptedWhileBlocked <= 18 && executed == 100;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_parallel_sort_comparator_and_nested()
+{
+    try
+    {
+        ThreadPool pool(4);
+        // Muchos repetidos y orden descendente
+        vector<int> data(200000);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = (int)((i * 7919) % 1000);
+        vector<int> expected = data;
+        sort(expected.begin(), expected.end(), greater<int>());
+        parallel_sort(pool, data.begin(), data.end(), greater<int>());
+        if (data != expected)
+            return false;
+
+        // Llamado desde adentro de una task: usa los deques del worker
+        vector<string> words(50000);
+        for (size_t i = 0; i < words.size(); ++i)
+            words[i] = to_string((i * 104729) % 50000);
+        vector<string> sortedWords = words;
+        sort(sortedWords.begin(), sortedWords.end());
+        pool.schedule([&]()
+                      { parallel_sort(pool, words.begin(), words.end()); });
+        pool.wait();
+        return words == sortedWords;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_parallel_scans()
+{
+    try
+    {
+        ThreadPool pool(4);
+        vector<uint64_t> input(1000003);
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = (i * 2654435761u) % 1000;
+
+        vector<uint64_t> expected(input.size()), got(input.size());
+        inclusive_scan(input.begin(), input.end(), expected.begin());
+        if (parallel_inclusive_scan(pool, input.begin(), input.end(), got.begin()) != got.end() || got != expected)
+            return false;
+
+        // Exclusive en el lugar
+        exclusive_scan(input.begin(), input.end(), expected.begin(), uint64_t(7));
+        got = input;
+        parallel_exclusive_scan(pool, got.begin(), got.end(), got.begin(), uint64_t(7));
+        if (got != expected)
+            return false;
+
+        // Composicion de funciones afines x -> a*x + b: asociativa pero no conmutativa
+        typedef pair<uint32_t, uint32_t> affine;
+        auto compose = [](const affine &f, const affine &g)
+        { return affine(g.first * f.first, g.first * f.second + g.second); };
+        vector<affine> fs(300000);
+        for (size_t i = 0; i < fs.size(); ++i)
+            fs[i] = affine(uint32_t(i * 3 + 1), uint32_t(i ^ 0x5bd1e995));
+        vector<affine> fexpected(fs.size()), fgot(fs.size());
+        inclusive_scan(fs.begin(), fs.end(), fexpected.begin(), compose);
+        parallel_inclusive_scan(pool, fs.begin(), fs.end(), fgot.begin(), compose);
+        return fgot == fexpected;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_parallel_copy_if_partition()
+{
+    try
+    {
+        ThreadPool pool(4);
+        vector<int> input(700001);
+        for (size_t i = 0; i < input.size(); ++i)
+            input[i] = (int)((i * 7919) % 10007);
+        auto isEven = [](int v)
+        { return v % 2 == 0; };
+
+        vector<int> expected, got(input.size());
+        copy_if(input.begin(), input.end(), back_inserter(expected), isEven);
+        auto end = parallel_copy_if(pool, input.begin(), input.end(), got.begin(), isEven);
+        got.resize(end - got.begin());
+        if (got != expected)
+            return false;
+
+        vector<int> yes(input.size()), no(input.size()), expYes, expNo;
+        partition_copy(input.begin(), input.end(), back_inserter(expYes), back_inserter(expNo), isEven);
+        auto ends = parallel_partition_copy(pool, input.begin(), input.end(), yes.begin(), no.begin(), isEven);
+        yes.resize(ends.first - yes.begin());
+        no.resize(ends.second - no.begin());
+        return yes == expYes && no == expNo;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_pipeline_order_and_token_bound()
+{
+    try
+    {
+        ThreadPool pool(4);
+        const int items = 5000;
+        const size_t maxTokens = 6;
+        struct record
+        {
+            int id;
+            long value;
+        };
+
+        int nextId = 0;
+        atomic<int> live{0}, maxLive{0};
+        vector<int> written;
+        size_t outOfOrderSeen = 0;
+
+        Pipeline<record> pipeline(pool, maxTokens);
+        pipeline.source([&](record &r)
+                        {
+                    if (nextId == items)
+                        return false;
+                    r.id = nextId++;
+                    int now = ++live;
+                    int prev = maxLive.load();
+                    while (now > prev && !maxLive.compare_exchange_weak(prev, now)) {}
+                    return true; })
+            .stage(kStageParallel, [](record &r)
+                   { r.value = (long)r.id * r.id; })
+            .stage(kStageSerialOutOfOrder, [&](record &)
+                   { outOfOrderSeen++; })
+            .stage(kStageSerialInOrder, [&](record &r)
+                   {
+                    if (r.value == (long)r.id * r.id)
+                        written.push_back(r.id);
+                    live--; });
+        pipeline.run();
+
+        if ((int)written.size() != items || outOfOrderSeen != (size_t)items)
+            return false;
+        for (int i = 0; i < items; ++i)
+            if (written[i] != i)
+                return false;
+        return maxLive <= (int)maxTokens;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_pipeline_stage_exception()
+{
+    try
+    {
+        ThreadPool pool(4);
+        int next = 0;
+        atomic<int> sunk{0};
+        Pipeline<int> pipeline(pool, 4);
+        pipeline.source([&](int &v)
+                        {
+                    if (next == 100000)
+                        return false;
+                    v = next++;
+                    return true; })
+            .stage(kStageParallel, [](int &v)
+                   {
+                    if (v == 50)
+                        throw runtime_error("bad record"); })
+            .stage(kStageSerialInOrder, [&](int &)
+                   { sunk++; });
+
+        bool caught = false;
+        try
+        {
+            pipeline.run();
+        }
+        catch (const runtime_error &)
+        {
+            caught = true;
+        }
+        // Se corto de leer al toque y el pool sigue andando
+        atomic<int> after{0};
+        pool.schedule([&after]()
+                      { after++; });
+        pool.wait();
+        return caught && next < 100000 && sunk < 100 && after == 1;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+task<void> coro_fill_channel(ThreadPool &pool, Channel<unique_ptr<int>> &channel, int items)
+{
+    co_await pool.schedule();
+    for (int i = 1; i <= items; ++i)
+    {
+        if (!co_await channel.asyncSend(make_unique<int>(i)))
+            break;
+    }
+    channel.close();
+}
+
+task<long> coro_drain_channel(Channel<unique_ptr<int>> &channel)
+{
+    long sum = 0;
+    while (true)
+    {
+        optional<unique_ptr<int>> v = co_await channel.receive();
+        if (!v)
+            break;
+        sum += **v;
+    }
+    co_return sum;
+}
+
+bool test_channel_move_only_bounded()
+{
+    try
+    {
+        ThreadPool pool(4);
+        Channel<unique_ptr<int>> channel(pool, 8);
+        const int items = 2000;
+
+        // Productor corutina en el pool; el canal de 8 lo estaciona sin
+        // trabar el worker
+        thread producer([&]()
+                        { sync_wait(coro_fill_channel(pool, channel, items)); });
+
+        // Consumidor corutina: cada receive vacio deja una continuacion
+        long sum = sync_wait(coro_drain_channel(channel));
+        producer.join();
+
+        // Receive con callback sobre un canal cerrado recibe nullopt
+        Semaphore got;
+        bool sawEnd = false;
+        channel.receive([&](optional<unique_ptr<int>> v)
+                        {
+            sawEnd = !v;
+            got.signal(); });
+        got.wait();
+        pool.wait();
+        return sum == (long)items * (items + 1) / 2 && sawEnd;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_channel_send_parks_on_single_worker()
+{
+    try
+    {
+        // Productor y consumidor comparten el unico worker: send estaciona
+        ThreadPool pool(1);
+        Channel<int> channel(pool, 8);
+        const int items = 1000;
+        long sum = 0;
+        Semaphore finished;
+
+        function<void(int)> sendFrom = [&](int i)
+        {
+            channel.send(i, [&, i](bool ok)
+                         {
+                if (ok && i < items)
+                    sendFrom(i + 1);
+                else
+                    channel.close(); });
+        };
+        function<void(optional<int>)> onValue = [&](optional<int> v)
+        {
+            if (!v)
+            {
+                finished.signal();
+                return;
+            }
+            sum += *v;
+            channel.receive(onValue);
+        };
+        pool.schedule([&]()
+                      { sendFrom(1); });
+        channel.receive(onValue);
+        finished.wait();
+
+        // El send bloqueante desde un worker con el canal lleno tira
+        Channel<int> full(pool, 1);
+        bool threw = false;
+        pool.schedule([&]()
+                      {
+            full.send(1);
+            try
+            {
+                full.send(2);
+            }
+            catch (const runtime_error &)
+            {
+                threw = true;
+            } });
+        pool.wait();
+        return sum == (long)items * (items + 1) / 2 && threw;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_spsc_channel_order()
+{
+    try
+    {
+        ThreadPool pool(2);
+        SpscChannel<int> channel(pool, 64);
+        const int items = 100000;
+        int expected = 0;
+        bool inOrder = true;
+        Semaphore finished;
+
+        // Cadena de receives: cada callback registra el siguiente
+        function<void(int)> onValue = [&](int v)
+        {
+            if (v != expected++)
+                inOrder = false;
+            if (expected == items)
+                finished.signal();
+            else
+                channel.receive(onValue);
+        };
+        channel.receive(onValue);
+
+        thread producer([&]()
+                        {
+            for (int i = 0; i < items; ++i)
+                channel.send(i); });
+        producer.join();
+        finished.wait();
+        pool.wait();
+        return inOrder && expected == items;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_worker_arena_reset_per_task()
+{
+    try
+    {
+        ThreadPool pool(1);
+        bool threwOutside = false;
+        try
+        {
+            ThreadPool::currentWorkerArena();
+        }
+        catch (const runtime_error &)
+        {
+            threwOutside = true;
+        }
+
+        atomic<bool> ok{true};
+        auto task = [&ok]()
+        {
+            Arena &arena = ThreadPool::currentWorkerArena();
+            if (arena.used() != 0) // la task anterior ya se reseteo
+                ok = false;
+            vector<int, ArenaAllocator<int>> v{ArenaAllocator<int>(arena)};
+            for (int i = 0; i < 1000; ++i)
+                v.push_back(i);
+            basic_string<char, char_traits<char>, ArenaAllocator<char>> str(200, 'x', ArenaAllocator<char>(arena));
+            if (v[999] != 999 || str.size() != 200 || arena.used() < 1000 * sizeof(int))
+                ok = false;
+        };
+
+        for (int i = 0; i < 50; ++i)
+            pool.schedule(task);
+        pool.wait();
+
+        // Con los chunks ya pedidos los temporales no pasan por malloc
+        size_t before = allocCount.load();
+        for (int i = 0; i < 200; ++i)
+            pool.schedule(task);
+        pool.wait();
+        size_t after = allocCount.load();
+        return threwOutside && ok && after == before;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_worker_local_histogram()
+{
+    try
+    {
+        ThreadPool pool(4);
+        atomic<int> constructed{0};
+        WorkerLocal<vector<long>> histograms(pool, [&constructed]()
+                                             {
+            constructed++;
+            return vector<long>(16, 0); });
+
+        // Cada worker acumula en su copia sin atomicos
+        for (int t = 0; t < 64; ++t)
+            pool.schedule([&histograms, t]()
+                          {
+                vector<long> &h = histograms.local();
+                for (int i = 0; i < 1000; ++i)
+                    h[(t * 1000 + i) % 16]++; });
+        pool.wait();
+        histograms.local()[0] += 5; // el hilo principal tambien tiene la suya
+
+        vector<long> total = histograms.combine([](const vector<long> &a, const vector<long> &b)
+                                                {
+            vector<long> sum(a);
+            for (size_t i = 0; i < sum.size(); ++i)
+                sum[i] += b[i];
+            return sum; });
+
+        long count = 0;
+        for (long c : total)
+            count += c;
+        // Copias lazy: a lo sumo una por worker mas la del hilo principal
+        return count == 64000 + 5 && total[1] == 4000 && constructed >= 2 && constructed <= 5;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_admission_control_sheds_low_priority()
+{
+    try
+    {
+        BasicThreadPool<MutexQueue, BlockingWait, CountingStats> pool(1);
+        pool.enableAdmissionControl(microseconds(2000), microseconds(20000));
+
+        // 300 tasks de 1ms con un solo worker: el tiempo en cola no para de crecer
+        atomic<int> normal{0};
+        for (int i = 0; i < 300; ++i)
+            pool.schedule([&normal]()
+                          {
+                sleep_for_ms(1);
+                normal++; });
+
+        bool sawOverload = false;
+        for (int i = 0; i < 200 && !sawOverload; ++i)
+        {
+            sleep_for_ms(5);
+            sawOverload = pool.overloaded();
+        }
+        atomic<int> low{0};
+        bool rejected = !pool.trySchedule([&low]()
+                                          { low++; });
+        pool.wait();
+
+        // Con la cola vacia se vuelve a aceptar
+        pool.schedule([]() {});
+        pool.wait();
+        bool accepted = pool.trySchedule([&low]()
+                                         { low++; });
+        pool.wait();
+        return sawOverload && rejected && accepted && normal == 300 && low == 1 &&
+               pool.statistics().rejected == 1;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+task<bool> coro_blocking_section(CompositeExecutor &ex)
+{
+    co_await ex.enterBlocking();
+    bool onBlocking = ex.blocking().currentWorkerId() >= 0;
+    sleep_for_ms(20); // aca puede bloquear tranquila
+    co_await ex.leaveBlocking();
+    co_return onBlocking && ex.cpu().currentWorkerId() >= 0;
+}
+
+bool test_composite_executor_isolates_blocking()
+{
+    try
+    {
+        CompositeExecutor ex(2, 64);
+        atomic<bool> release{false};
+        atomic<int> blocked{0}, computed{0}, handedBack{0};
+
+        // Mas tareas bloqueantes que workers de computo
+        for (int i = 0; i < 16; ++i)
+            ex.scheduleBlocking([&]()
+                                {
+                blocked++;
+                while (!release)
+                    sleep_for_ms(1);
+                // Al terminar le pasa algo al pool de computo
+                ex.schedule([&handedBack]() { handedBack++; }); });
+
+        // El computo sigue andando con los bloqueantes colgados
+        auto t0 = steady_clock::now();
+        for (int i = 0; i < 100; ++i)
+            ex.schedule([&computed]()
+                        { computed++; });
+        ex.cpu().wait();
+        auto elapsed = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+        bool cpuUnaffected = computed == 100 && elapsed < 1000;
+
+        bool hopped = sync_wait(coro_blocking_section(ex));
+
+        release = true;
+        ex.wait(); // incluye lo que los bloqueantes mandaron al computo
+        return cpuUnaffected && hopped && blocked == 16 && handedBack == 16;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_composite_executor_handoffs_and_shrinks()
+{
+    try
+    {
+        CompositeExecutor ex(2, 32);
+
+        // Cadenas bloqueo -> computo -> bloqueo: wait() no puede volver en el medio
+        atomic<int> finished{0};
+        atomic<bool> release{false};
+        for (int i = 0; i < 20; ++i)
+            ex.scheduleBlocking([&]()
+                                {
+                while (!release)
+                    sleep_for_ms(1);
+                ex.schedule([&]()
+                            { ex.scheduleBlocking([&]()
+                                                  {
+                                sleep_for_ms(2);
+                                finished++; }); }); });
+
+        // Con 20 bloqueadas el pool de bloqueo crece mas alla de sus 2 fijos
+        bool grew = false;
+        for (int i = 0; i < 200 && !grew; ++i)
+        {
+            sleep_for_ms(5);
+            grew = ex.blocking().liveWorkers() >= 20;
+        }
+        release = true;
+        ex.wait();
+        bool allDone = finished == 20;
+
+        // Y cuando vuelven, los de compensacion se retiran
+        bool shrank = ex.blocking().liveWorkers() <= 2;
+        return grew && allDone && shrank;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_blocking_region_compensates()
+{
+    try
+    {
+        ThreadPool pool(2);
+        Semaphore gate;
+        atomic<int> passed{0};
+
+        // Los dos workers se quedan bloqueados esperando a una tercera task
+        for (int i = 0; i < 2; ++i)
+            pool.schedule([&]()
+                          {
+                ThreadPool::blocking_region region(pool);
+                gate.wait();
+                passed++; });
+        sleep_for_ms(50);
+        // Cada bloqueo arma el lugar de su compensacion, no antes
+        bool builtOnDemand = pool.builtWorkers() == 4;
+
+        // Sin compensacion esta nunca conseguiria worker
+        atomic<size_t> liveWhileBlocked{0};
+        pool.schedule([&]()
+                      {
+            liveWhileBlocked = pool.liveWorkers();
+            gate.signal();
+            gate.signal(); });
+        pool.wait();
+        bool grew = liveWhileBlocked > 2;
+
+        // Los de compensacion se retiran al volver los bloqueados
+        for (int i = 0; i < 200 && pool.liveWorkers() > 2; ++i)
+            sleep_for_ms(5);
+        bool retired = pool.liveWorkers() == 2;
+
+        // Y el pool sigue andando con los de siempre
+        atomic<int> after{0};
+        for (int i = 0; i < 100; ++i)
+            pool.schedule([&after]()
+                          { after++; });
+        pool.wait();
+
+        // size() sigue siendo lo pedido; los lugares de compensacion van aparte
+        ThreadPool single(1);
+        ThreadPool wide(2, 8);
+        bool sizes = pool.size() == 2 && single.size() == 1 && single.maxWorkers() == 2 &&
+                     wide.size() == 2 && wide.maxWorkers() == 8;
+
+        // Sin bloqueos no se arma ningun lugar de compensacion
+        for (int i = 0; i < 100; ++i)
+            wide.schedule([&after]()
+                          { after++; });
+        wide.wait();
+        bool noExtra = wide.builtWorkers() <= wide.size();
+        return passed == 2 && grew && retired && after == 200 && pool.liveWorkers() == 2 && sizes &&
+               builtOnDemand && noExtra;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_watchdog_flags_stalled_task()
+{
+    try
+    {
+        mutex reportsLock;
+        vector<task_report_t> reports; // antes que el pool: el callback las usa hasta el final
+        ThreadPool pool(2);
+        pool.enableWatchdog(milliseconds(40), [&](const task_report_t &r)
+                            {
+            lock_guard<mutex> lg(reportsLock);
+            reports.push_back(r); }, 3);
+
+        atomic<int> quick{0};
+        pool.schedule([]()
+                      { sleep_for_ms(200); }, "slow-task");
+        for (int i = 0; i < 200; ++i)
+            pool.schedule([&quick]()
+                          { quick++; });
+        pool.wait();
+
+        // El watchdog ve que termino en su proxima muestra
+        vector<task_report_t> top;
+        for (int i = 0; i < 100; ++i)
+        {
+            top = pool.slowestTasks();
+            if (!top.empty())
+                break;
+            sleep_for_ms(10);
+        }
+
+        lock_guard<mutex> lg(reportsLock);
+        bool flagged = reports.size() == 1 && reports[0].name && string(reports[0].name) == "slow-task" &&
+                       reports[0].elapsed >= milliseconds(40);
+        bool ranked = !top.empty() && top.size() <= 3 && top[0].name && string(top[0].name) == "slow-task" &&
+                      top[0].elapsed >= milliseconds(190) && top[0].worker == reports[0].worker;
+        return quick == 200 && flagged && ranked;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_shutdown_modes()
+{
+    try
+    {
+        // Cancelar pendientes: solo termina la que ya corria
+        shutdown_report_t cancelled;
+        atomic<int> ran{0};
+        bool rejectedAfter = false;
+        {
+            ThreadPool pool(1);
+            atomic<bool> release{false};
+            pool.schedule([&release]()
+                          {
+                while (!release)
+                    sleep_for_ms(1); });
+            for (int i = 0; i < 1000; ++i)
+                pool.schedule([&ran]()
+                              { ran++; });
+            sleep_for_ms(20);
+            thread releaser([&release]()
+                            {
+                sleep_for_ms(50);
+                release = true; });
+            cancelled = pool.shutdown(kShutdownCancelPending);
+            releaser.join();
+            try
+            {
+                pool.schedule([]() {});
+            }
+            catch (const runtime_error &)
+            {
+                rejectedAfter = true;
+            }
+        }
+        bool cancelOk = cancelled.completed == 1 && cancelled.dropped == 1000 && ran == 0 && rejectedAfter;
+
+        // Con deadline: drena un rato y descarta el resto
+        ThreadPool slow(1);
+        atomic<int> slowRan{0};
+        for (int i = 0; i < 100; ++i)
+            slow.schedule([&slowRan]()
+                          {
+                sleep_for_ms(10);
+                slowRan++; });
+        auto t0 = steady_clock::now();
+        shutdown_report_t bounded = slow.shutdown(kShutdownDeadline, milliseconds(100));
+        auto took = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+        bool deadlineOk = bounded.completed + bounded.dropped == 100 && bounded.dropped > 0 &&
+                          bounded.completed == (size_t)slowRan && took < 1000;
+
+        // Drain: corre todo, incluso lo que programan las tasks mientras se cierra
+        ThreadPool drained(2);
+        atomic<int> drainedRan{0};
+        for (int i = 0; i < 50; ++i)
+            drained.schedule([&]()
+                             {
+                sleep_for_ms(1);
+                drained.schedule([&drainedRan]() { drainedRan++; });
+                drainedRan++; });
+        shutdown_report_t all = drained.shutdown(kShutdownDrain);
+        bool drainOk = drainedRan == 100 && all.dropped == 0 && all.completed <= 100;
+
+        return cancelOk && deadlineOk && drainOk;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_saturation_caller_runs()
+{
+    try
+    {
+        BasicThreadPool<MutexQueue, BlockingWait, CountingStats> pool(1);
+        // El unico worker queda trabado y la cola se llena
+        atomic<bool> release{false};
+        pool.schedule([&release]()
+                      {
+                while (!release)
+                    sleep_for_ms(1); });
+        sleep_for_ms(20);
+        atomic<int> queued{0};
+        for (int i = 0; i < 10; ++i)
+            pool.schedule([&queued]()
+                          { queued++; });
+
+        // Saturado: la siguiente corre aca mismo
+        pool.setSaturationPolicy(kSaturationCallerRuns, 4);
+        thread::id ranOn;
+        pool.schedule([&ranOn]()
+                      { ranOn = this_thread::get_id(); });
+        bool callerRan = ranOn == this_thread::get_id();
+
+        // Con inline-cheap solo se adelantan las marcadas como baratas
+        pool.setSaturationPolicy(kSaturationInlineCheap, 4);
+        atomic<bool> normalInline{false};
+        thread::id cheapOn;
+        pool.schedule([&normalInline]()
+                      { normalInline = true; }, kTaskNormal);
+        pool.schedule([&cheapOn]()
+                      { cheapOn = this_thread::get_id(); }, kTaskCheap);
+        bool normalQueued = !normalInline;
+        bool cheapRan = cheapOn == this_thread::get_id();
+
+        // Caller-runs vale tambien pa' las con nombre o token; las con clave
+        // siempre van a su worker
+        pool.setSaturationPolicy(kSaturationCallerRuns, 4);
+        CancellationToken token;
+        thread::id namedOn, tokenOn;
+        atomic<bool> keyedRan{false};
+        pool.schedule([&namedOn]()
+                      { namedOn = this_thread::get_id(); }, "named");
+        pool.schedule([&tokenOn]()
+                      { tokenOn = this_thread::get_id(); }, token);
+        pool.scheduleOn(7, [&keyedRan]()
+                        { keyedRan = true; });
+        bool othersRan = namedOn == this_thread::get_id() && tokenOn == this_thread::get_id();
+        bool keyedQueued = !keyedRan;
+
+        release = true;
+        pool.wait();
+        return callerRan && normalQueued && cheapRan && normalInline && queued == 10 &&
+               othersRan && keyedQueued && keyedRan && pool.statistics().inlined == 4;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_batched_delivery_is_stolen()
+{
+    try
+    {
+        ThreadPool pool(2);
+
+        // Calentar: muchas tasks cortas, asi los lotes salen grandes
+        atomic<int> warm{0};
+        for (int i = 0; i < 20000; ++i)
+            pool.schedule([&warm]()
+                          { warm++; });
+        pool.wait();
+
+        // Los dos workers trabados y atras una lenta con 200 cortas: la lenta
+        // se lleva un lote, pero el otro worker se lo tiene que robar
+        atomic<bool> release{false};
+        for (int i = 0; i < 2; ++i)
+            pool.schedule([&release]()
+                          {
+                while (!release)
+                    sleep_for_ms(1); });
+        sleep_for_ms(20);
+        atomic<int> shortRan{0};
+        int seenBySlow = -1;
+        pool.schedule([&]()
+                      {
+                sleep_for_ms(300);
+                seenBySlow = shortRan; });
+        for (int i = 0; i < 200; ++i)
+            pool.schedule([&shortRan]()
+                          { shortRan++; });
+        release = true;
+        pool.wait();
+        return warm == 20000 && shortRan == 200 && seenBySlow == 200;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_spsc_channel_send_parks_on_single_worker()
+{
+    try
+    {
+        // Productor y consumidor comparten el unico worker: send estaciona
+        ThreadPool pool(1);
+        SpscChannel<int> channel(pool, 2);
+        const int items = 1000;
+        long sum = 0;
+        int received = 0;
+        Semaphore finished;
+
+        function<void(int)> sendFrom = [&](int i)
+        {
+            if (i > items)
+                return;
+            channel.send(i, [&, i]()
+                         { sendFrom(i + 1); });
+        };
+        function<void(int)> onValue = [&](int v)
+        {
+            sum += v;
+            if (++received == items)
+                finished.signal();
+            else
+                channel.receive(onValue);
+        };
+        pool.schedule([&]()
+                      { sendFrom(1); });
+        channel.receive(onValue);
+        finished.wait();
+
+        // El send bloqueante desde un worker con el canal lleno tira
+        SpscChannel<int> full(pool, 1);
+        bool threw = false;
+        pool.schedule([&]()
+                      {
+            full.send(1);
+            try
+            {
+                full.send(2);
+            }
+            catch (const runtime_error &)
+            {
+                threw = true;
+            } });
+        pool.wait();
+        return sum == (long)items * (items + 1) / 2 && threw;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_saturation_counts_handed_out_tasks()
+{
+    try
+    {
+        ThreadPool pool(1);
+        // El unico worker trabado y diez tasks con clave en su backlog: la
+        // cola compartida queda vacia pero el pool esta saturado igual
+        atomic<bool> release{false};
+        pool.schedule([&release]()
+                      {
+                while (!release)
+                    sleep_for_ms(1); });
+        sleep_for_ms(20);
+        atomic<int> keyed{0};
+        for (int i = 0; i < 10; ++i)
+            pool.scheduleOn(0, [&keyed]()
+                            { keyed++; });
+        sleep_for_ms(20);
+
+        pool.setSaturationPolicy(kSaturationCallerRuns, 4);
+        thread::id ranOn;
+        pool.schedule([&ranOn]()
+                      { ranOn = this_thread::get_id(); });
+        bool callerRan = ranOn == this_thread::get_id();
+
+        release = true;
+        pool.wait();
+        return callerRan && keyed == 10;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Lifecycle (L): pruebas de ciclo de vida del pool
+// ---------------------------------------------------------------------------
+
+bool test_destructor_waits_for_tasks()
+{
+    auto start = high_resolution_clock::now();
+    {
+        ThreadPool pool(1);
+        pool.schedule([]()
+                      { sleep_for_ms(100); });
+    } // Destructor acá
+    auto end = high_resolution_clock::now();
+    auto ms = duration_cast<milliseconds>(end - start).count();
+    return ms >= 100;
+}
+
+bool test_repeated_pool_creation()
+{
+    try
+    {
+        const int rounds = 100;
+        for (int r = 0; r < rounds; ++r)
+        {
+            ThreadPool pool(2);
+            atomic<int> counter{0};
+            for (int i = 0; i < 10; ++i)
+            {
+                pool.schedule([&]()
+                              { counter.fetch_add(1, memory_order_relaxed); });
+            }
+            pool.wait();
+            if (counter != 10)
+                return false;
+        }
+        return true;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Nesting (N): scheduling anidado profundo
+// ---------------------------------------------------------------------------
+
+bool test_deep_nested_scheduling()
+{
+    promise<bool> prom;
+    auto fut = prom.get_future();
+
+    thread t([&prom]()
+             {
+        try {
+            ThreadPool pool(4);
+            atomic<int> count(0);
+            pool.schedule([&]() {
+                count++;
+                pool.schedule([&]() {
+                    count++;
+                    pool.schedule([&]() {
+                        count++;
+                    });
+                });
+            });
+            pool.wait();
+            prom.set_value(count == 3);
+        } catch (...) {
+            prom.set_value(false);
+        } });
+
+    t.join();         // espera que el hilo termine antes de usar el future
+    return fut.get(); // seguro: no hay acceso concurrente al shared state
+}
+
+bool test_extreme_nested_scheduling()
+{
+    const int depth = 1000;
+    const int timeout_ms = 2000;
+
+    promise<bool> prom;
+    auto fut = prom.get_future();
+
+    thread t([&prom, depth, timeout_ms]()
+             {
+        try {
+            ThreadPool pool(4);
+            atomic<int> leafCount{0};
+
+            function<void(int)> scheduleDepth = [&](int d) {
+                if (d == 0) {
+                    leafCount.fetch_add(1, memory_order_relaxed);
+                    return;
+                }
+                pool.schedule([&, d]() {
+                    scheduleDepth(d - 1);
+                });
+            };
+
+            auto start = chrono::steady_clock::now();
+            scheduleDepth(depth);
+            pool.wait();
+            auto end = chrono::steady_clock::now();
+
+            auto elapsed = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+            prom.set_value((elapsed <= timeout_ms) && (leafCount == 1));
+        } catch (...) {
+            prom.set_value(false);
+        } });
+
+    t.join();         // asegura que set_value ya ocurrió
+    return fut.get(); // ahora es seguro
+}
+
+void fork_join_quicksort(ThreadPool &pool, int *first, int *last)
+{
+    if (last - first <= 2048)
+    {
+        sort(first, last);
+        return;
+    }
+    int pivot = first[(last - first) / 2];
+    int *mid1 = partition(first, last, [pivot](int x)
+                          { return x < pivot; });
+    int *mid2 = partition(mid1, last, [pivot](int x)
+                          { return x == pivot; });
+    pool.invoke([&]()
+                { fork_join_quicksort(pool, first, mid1); },
+                [&]()
+                { fork_join_quicksort(pool, mid2, last); });
+}
+
+bool test_fork_join_quicksort()
+{
+    try
+    {
+        ThreadPool pool(4);
+        vector<int> data(1 << 20);
+        unsigned x = 12345;
+        for (auto &v : data)
+        {
+            x = x * 1103515245 + 12345;
+            v = (x >> 8) % 100000;
+        }
+        vector<int> expected = data;
+        sort(expected.begin(), expected.end());
+
+        pool.schedule([&]()
+                      { fork_join_quicksort(pool, data.data(), data.data() + data.size()); });
+        pool.wait();
+        return data == expected;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_fork_join_extreme_depth()
+{
+    const int depth = 1000;
+    const int timeout_ms = 2000;
+    try
+    {
+        ThreadPool pool(4);
+        atomic<int> leaves{0};
+
+        function<void(int)> tree = [&](int d)
+        {
+            if (d == 0)
+            {
+                leaves.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+            // Una rama profunda y otra hoja en cada nivel
+            pool.invoke([&, d]()
+                        { tree(d - 1); },
+                        [&]()
+                        { leaves.fetch_add(1, memory_order_relaxed); });
+        };
+
+        auto start = steady_clock::now();
+        pool.schedule([&]()
+                      { tree(depth); });
+        pool.wait();
+        auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start).count();
+        return leaves == depth + 1 && elapsed <= timeout_ms;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Timing (T): mediciones de paralelismo
+// ---------------------------------------------------------------------------
+
+bool test_parallel_speedup()
+{
+    const int tasks = 4;
+    const int sleep_ms = 100;
+    ThreadPool pool(tasks);
+    auto t0 = high_resolution_clock::now();
+    for (int i = 0; i < tasks; ++i)
+    {
+        pool.schedule([=]()
+                      { sleep_for_ms(sleep_ms); });
+    }
+    pool.wait();
+    auto t1 = high_resolution_clock::now();
+    auto elapsed = duration_cast<milliseconds>(t1 - t0).count();
+    // Debería ser significativamente menor que tasks * sleep_ms
+    return elapsed < (sleep_ms * tasks / 2);
+}
+
+bool test_short_rounds_wait_latency()
+{
+    try
+    {
+        ThreadPool pool(4);
+        atomic<int> counter{0};
+        const int rounds = 2000;
+
+        auto t0 = high_resolution_clock::now();
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (int i = 0; i < 4; ++i)
+                pool.schedule([&counter]()
+                              { counter.fetch_add(1, memory_order_relaxed); });
+            pool.wait(); // rondas de microsegundos: aca tiene que girar, no dormir
+        }
+        auto t1 = high_resolution_clock::now();
+        auto elapsed = duration_cast<milliseconds>(t1 - t0).count();
+        return counter == rounds * 4 && elapsed < 2000;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_pool_construction_is_lazy()
+{
+    try
+    {
+        // Antes de la primera task no hay ni hilos ni lugares de worker
+        ThreadPool *pool = new ThreadPool(1024);
+        bool empty = pool->liveWorkers() == 0 && pool->builtWorkers() == 0;
+
+        // Una sola task arma un solo worker
+        atomic<int> counter{0};
+        pool->schedule([&counter]()
+                       { counter++; });
+        pool->wait();
+        bool one = pool->liveWorkers() == 1 && pool->builtWorkers() == 1;
+        delete pool;
+        return counter == 1 && empty && one;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_create_run_destroy_cycles()
+{
+    try
+    {
+        const int cycles = 500;
+        auto t0 = high_resolution_clock::now();
+        for (int c = 0; c < cycles; ++c)
+        {
+            ThreadPool pool(16);
+            atomic<int> counter{0};
+            pool.schedule([&counter]()
+                          { counter++; });
+            pool.wait();
+            if (counter != 1)
+                return false;
+        }
+        auto t1 = high_resolution_clock::now();
+        auto elapsed = duration_cast<milliseconds>(t1 - t0).count();
+        // Con arranque lazy cada ciclo crea 2 hilos en vez de 17
+        return elapsed < 2000;
+    }
+    catch (...)
+    {
+        return false;
+    }
+}
+
+bool test_parallel_sort_thread_counts()
+{
+    try
+    {
+        // Mismo input de 1M contra std::sort con distintos tamanos de pool
+        // (las corridas de 10M-100M estan en bench.cc: make bench && ./bench)
+        vector<uint32_t> input(1 << 20);
+        uint32_t x = 2463534242u;
+        for (auto &v : input)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            v = x;
+        }
+        vector<uint32_t> expected = input;
+        sort(expected.begin(), expected.end());
+
+        for (size_t threads : {1, 2, 4, 8})
+        {
+            ThreadPool pool(threads);
+            vector<uint32_t> data = input;
+            parallel_sort(pool, data.begin(), data.end());
+            if (data != expected)
+                return false;
+        }
+        return true;
+    }
+    catch (...)
+    {
+        return false;
     }
-    pool.wait();
-    auto t1 = high_resolution_clock::now();
-    auto elapsed = duration_cast<milliseconds>(t1 - t0).count();
-    // Debería ser significativamente menor que tasks * sleep_ms
-    return elapsed < (sleep_ms * tasks / 2);
 }
 
 // ---------------------------------------------------------------------------
@@ -1294,6 +3133,46 @@ int main()
         {"F11", "Multiple wait() calls inside tasks", test_multiple_wait_inside_tasks},
         {"F12", "Concurrent schedule/wait in parallel", test_concurrent_schedule_wait_parallel},
         {"F13", "Worker state corruption attempt", test_worker_state_corruption},
+        {"F14", "Coroutines hop onto workers via co_await schedule()", test_coroutine_schedule},
+        {"F15", "Coroutine exceptions reach sync_wait", test_coroutine_exception_propagation},
+        {"F16", "Reactor schedules pipe readiness on the pool", test_reactor_pipe_readiness},
+        {"F17", "Reactor serves 500 sockets with 2 workers", test_reactor_many_sockets_few_workers},
+        {"F18", "Reactor remove() stops callbacks", test_reactor_remove_stops_callbacks},
+        {"F19", "Cancelled token skips 1000 pending tasks", test_cancel_pending_tasks},
+        {"F20", "Running task polls its cancellation token", test_cancel_running_task_polls_token},
+        {"F21", "Producer buffers with 4 producers and wait()", test_producer_buffers_concurrent},
+        {"F22", "Producer buffers flush within latency bound", test_producer_buffers_latency_bound},
+        {"F23", "Steady-state scheduling does no allocations", test_steady_state_no_allocations},
+        {"F24", "scheduleOn keeps a key on the same worker", test_keyed_affinity_same_worker},
+        {"F25", "Idle workers steal from an overloaded key", test_keyed_affinity_steals_when_overloaded},
+        {"F26", "Strand runs tasks in FIFO order, never in parallel", test_strand_fifo_without_mutex},
+        {"F27", "Two strands fed by 4 producers", test_strand_concurrent_producers},
+        {"F28", "Facades on the default pool wait independently", test_facades_share_default_pool},
+        {"F29", "Facade concurrency limit on a shared pool", test_facade_concurrency_limit},
+        {"F30", "Lock-free queue + spin wait + counting stats policies", test_policy_lockfree_spin_counting},
+        {"F31", "Bounded queue policy applies backpressure", test_policy_bounded_queue_backpressure},
+        {"F32", "parallel_sort with comparator and from a worker", test_parallel_sort_comparator_and_nested},
+        {"F33", "Parallel inclusive/exclusive scans", test_parallel_scans},
+        {"F34", "parallel_copy_if and parallel_partition_copy", test_parallel_copy_if_partition},
+        {"F35", "Pipeline keeps serial order and bounds tokens", test_pipeline_order_and_token_bound},
+        {"F36", "Pipeline stops reading when a stage throws", test_pipeline_stage_exception},
+        {"F37", "Bounded Channel moves values to coroutine receivers", test_channel_move_only_bounded},
+        {"F38", "SPSC channel delivers in order via continuations", test_spsc_channel_order},
+        {"F39", "Worker arenas serve task temporaries and reset", test_worker_arena_reset_per_task},
+        {"F40", "WorkerLocal histograms combine once at the end", test_worker_local_histogram},
+        {"F41", "CoDel admission control rejects low-priority tasks", test_admission_control_sheds_low_priority},
+        {"F42", "Composite executor keeps blocking work off CPU pool", test_composite_executor_isolates_blocking},
+        {"F43", "blocking_region adds and retires compensating workers", test_blocking_region_compensates},
+        {"F44", "Watchdog flags a stalled task and ranks the slowest", test_watchdog_flags_stalled_task},
+        {"F45", "shutdown() drain, cancel-pending and deadline modes", test_shutdown_modes},
+        {"F46", "Saturation policy runs tasks on the caller", test_saturation_caller_runs},
+        {"F47", "Batched deliveries are stolen from a busy worker", test_batched_delivery_is_stolen},
+        {"F48", "Producer buffers of destroyed pools are forgotten", test_producer_buffers_forget_dead_pools},
+        {"F49", "invoke() forks without allocating", test_invoke_does_not_allocate},
+        {"F50", "Bounded Channel send parks instead of blocking a worker", test_channel_send_parks_on_single_worker},
+        {"F51", "CompositeExecutor waits through handoffs and shrinks its blocking pool", test_composite_executor_handoffs_and_shrinks},
+        {"F52", "SpscChannel send parks instead of blocking a worker", test_spsc_channel_send_parks_on_single_worker},
+        {"F53", "Saturation counts tasks already handed to workers", test_saturation_counts_handed_out_tasks},
 
         // Errores (H)
         {"H01", "Wait inside task should deadlock", test_wait_inside_task},
@@ -1311,10 +3190,16 @@ int main()
         // Anidamiento (N)
         {"N01", "Deep nested task scheduling", test_deep_nested_scheduling},
         {"N02", "Extreme nested scheduling (1000)", test_extreme_nested_scheduling},
+        {"N03", "Fork-join quicksort with invoke()", test_fork_join_quicksort},
+        {"N04", "Fork-join recursion 1000 levels deep", test_fork_join_extreme_depth},
 
         // Timing / Benchmark (T)
         {"T01", "Parallel speedup benchmark (4 tasks)", test_parallel_speedup},
-        {"T02", "Scalability bottleneck test", test_scalability_with_mutex_contention}};
+        {"T02", "Scalability bottleneck test", test_scalability_with_mutex_contention},
+        {"T03", "2000 short schedule/wait rounds", test_short_rounds_wait_latency},
+        {"T04", "A 1024-thread pool builds no workers before its first task", test_pool_construction_is_lazy},
+        {"T05", "500 create-run-destroy cycles", test_create_run_destroy_cycles},
+        {"T06", "parallel_sort matches std::sort across pool sizes", test_parallel_sort_thread_counts}};
 
     for (const auto &t : tests)
     {
@@ -0,0 +1,1356 @@
+#ifndef _thread_pool_impl_
+#define _thread_pool_impl_
+
+// Definiciones de BasicThreadPool. Se incluye solo desde thread-pool.h
+
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::BasicThreadPool(size_t numThreads, size_t maxThreads)
+    : wts(max(maxThreads != 0 ? maxThreads : numThreads * 2, numThreads)), // lo que pasa de numThreads es pa' compensar bloqueos
+      newTaskSemaphore(0),
+      outstanding(0),
+      waiters(0),
+      spinHitRate(pool_detail::kSpinRateOne / 2),
+      avgTaskNs(0),
+      done(false),
+      poolId(pool_detail::newPoolId()),
+      batchSize(0),
+      maxStageDelay(0),
+      stagedTasks(0),
+      idleWorkers(0),
+      startedWorkers(0),
+      builtSlots(0),
+      baseWorkers(numThreads),
+      runningWorkers(0),
+      blockedWorkers(0),
+      admissionControl(false),
+      sojournTarget(0),
+      sojournInterval(0),
+      shedding(false),
+      watchdogOn(false),
+      stallThreshold(0),
+      slowestLimit(0),
+      saturationMode(kSaturationEnqueue),
+      saturationDepth(0),
+      closing(false),
+      dropping(false),
+      closingCompleted(0),
+      droppedTasks(0)
+{
+    // Los workers (su lugar y su hilo) y el dispatcher se arman recien cuando
+    // hay trabajo: aca solo queda la tabla de punteros en cero
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::startDispatcher()
+{
+    call_once(dispatcherOnce, [this]()
+              { dt = thread(&BasicThreadPool::dispatcher, this); });
+}
+
+// Con workerLock tomado. Un lugar se arma la primera vez que hace falta
+// (los de siempre al arrancar su hilo, los de compensacion en enterBlocking)
+// y queda hasta el destructor
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+worker_t &BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::buildSlot(size_t i)
+{
+    worker_t *w = slotAt(i);
+    if (!w)
+    {
+        w = new worker_t();
+        w->available = false;
+        w->assigned = false;
+        w->started = false;
+        w->retiring = false;
+        w->id = i; // hilo worker
+        wts[i].store(w, memory_order_release); // los que recorren sin lock lo ven entero
+        builtSlots++;
+    }
+    return *w;
+}
+
+// Con workerLock tomado. Un worker de compensacion que se retiro reusa su lugar
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+worker_t &BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::startWorker(size_t i)
+{
+    worker_t *w = &buildSlot(i);
+    if (w->ts.joinable())
+        w->ts.join(); // un worker de compensacion que ya se retiro
+    w->retiring = false;
+    w->started = true;
+    startedWorkers++;
+    w->ts = thread(&BasicThreadPool::worker, this, i);
+    return *w;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::schedule(const function<void(void)> &thunk)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot schedule null function");
+    }
+
+    job_node_t *node = allocJobNode();
+    node->job.thunk.emplace(thunk);
+    enqueue(node);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+template <typename F, typename>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::schedule(F &&fn)
+{
+    job_node_t *node = allocJobNode();
+    node->job.thunk.emplace(forward<F>(fn));
+    enqueue(node);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::schedule(const function<void(void)> &thunk, const CancellationToken &token)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot schedule null function");
+    }
+
+    job_node_t *node = allocJobNode();
+    node->job.thunk.emplace(thunk);
+    node->job.token = token;
+    enqueue(node);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::scheduleOn(size_t key, const function<void(void)> &thunk)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot schedule null function");
+    }
+    if (baseWorkers == 0)
+    {
+        throw invalid_argument("Cannot schedule keyed task on a pool without workers");
+    }
+
+    // Mezclar la clave (splitmix64) pa' que claves seguidas no caigan juntas
+    uint64_t h = key + 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+
+    job_node_t *node = allocJobNode();
+    node->job.thunk.emplace(thunk);
+    node->job.affinity = h % baseWorkers;
+    enqueue(node);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::schedule(coroutine_handle<> handle)
+{
+    if (!handle)
+    {
+        throw invalid_argument("Cannot schedule null coroutine handle");
+    }
+
+    job_node_t *node = allocJobNode();
+    node->job.handle = handle;
+    enqueue(node);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::enqueue(job_node_t *node)
+{
+    if (runInline(node))
+        return;
+
+    if (admissionControl)
+        node->job.enqueued = chrono::steady_clock::now();
+
+    if (batchSize > 0)
+    {
+        stage(node);
+        return;
+    }
+
+    if (done)
+    {
+        freeJobNode(node);
+        throw runtime_error("Cannot schedule task on destroyed ThreadPool");
+    }
+    outstanding.fetch_add(1); // antes de que un worker la pueda terminar
+    stats.onSchedule();
+    taskQueue.push(node);
+    startDispatcher();
+    // Despertar al dispatcher
+    newTaskSemaphore.signal();
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::enableProducerBuffers(size_t batch, chrono::microseconds maxDelay)
+{
+    if (batch == 0)
+    {
+        throw invalid_argument("Producer buffer batch size must be positive");
+    }
+    maxStageDelay = maxDelay;
+    batchSize = batch;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::enableAdmissionControl(chrono::microseconds target, chrono::microseconds interval)
+{
+    if (target.count() <= 0 || interval.count() <= 0)
+    {
+        throw invalid_argument("Admission control target and interval must be positive");
+    }
+    sojournTarget = target;
+    sojournInterval = interval;
+    admissionControl = true;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::schedule(const function<void(void)> &thunk, task_hint hint)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot schedule null function");
+    }
+    job_node_t *node = allocJobNode();
+    node->job.thunk.emplace(thunk);
+    node->job.cheap = hint == kTaskCheap;
+    enqueue(node);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::setSaturationPolicy(saturation_mode mode, size_t maxQueueDepth)
+{
+    saturationDepth = maxQueueDepth;
+    saturationMode = mode;
+}
+
+// Corre la task en el hilo que llama si la politica lo pide y el pool esta
+// saturado. Lo barato se mira primero: la profundidad de la cola puede tomar lock
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+bool BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::runInline(job_node_t *node)
+{
+    int mode = saturationMode.load(memory_order_relaxed);
+    if (mode == kSaturationEnqueue || (mode == kSaturationInlineCheap && !node->job.cheap))
+        return false;
+    if (node->job.affinity >= 0 || node->job.handle)
+        return false; // con clave o corutina: siempre a un worker
+    if (idleWorkers.load(memory_order_relaxed) > 0 || startedWorkers.load(memory_order_relaxed) < baseWorkers)
+        return false; // hay (o puede haber) alguien libre
+    // Lo que espera worker es lo programado y sin terminar menos lo que
+    // corre: asi cuentan tambien los lotes y backlogs que ya salieron de la cola
+    int idle = max(idleWorkers.load(memory_order_relaxed), 0);
+    size_t running = startedWorkers.load(memory_order_relaxed) - idle;
+    size_t total = outstanding.load(memory_order_relaxed);
+    if (total < running + saturationDepth.load(memory_order_relaxed))
+        return false;
+    if (done)
+    {
+        freeJobNode(node);
+        throw runtime_error("Cannot schedule task on destroyed ThreadPool");
+    }
+
+    if (node->job.cancelled())
+    {
+        stats.onSkip();
+        freeJobNode(node);
+        return true;
+    }
+    stats.onInline();
+    try
+    {
+        node->job.run();
+    }
+    catch (...)
+    {
+        freeJobNode(node);
+        throw;
+    }
+    freeJobNode(node);
+    return true;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::schedule(const function<void(void)> &thunk, const char *name)
+{
+    if (!thunk)
+    {
+        throw invalid_argument("Cannot schedule null function");
+    }
+
+    job_node_t *node = allocJobNode();
+    node->job.thunk.emplace(thunk);
+    node->job.name = name;
+    enqueue(node);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::enableWatchdog(chrono::milliseconds threshold,
+                                                                          const function<void(const task_report_t &)> &callback,
+                                                                          size_t topN)
+{
+    if (threshold.count() <= 0)
+    {
+        throw invalid_argument("Watchdog threshold must be positive");
+    }
+    if (watchdogOn.exchange(true))
+    {
+        throw runtime_error("Watchdog already enabled");
+    }
+    stallThreshold = threshold;
+    onStall = callback;
+    slowestLimit = topN;
+    wd = thread(&BasicThreadPool::watchdog, this);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+vector<task_report_t> BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::slowestTasks()
+{
+    lock_guard<mutex> lg(watchdogLock);
+    return slowest;
+}
+
+// Con watchdogLock tomado
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::recordSlow(const task_report_t &report)
+{
+    if (slowestLimit == 0)
+        return;
+    auto pos = find_if(slowest.begin(), slowest.end(), [&report](const task_report_t &r)
+                       { return r.elapsed < report.elapsed; });
+    if (pos == slowest.end() && slowest.size() >= slowestLimit)
+        return;
+    slowest.insert(pos, report);
+    if (slowest.size() > slowestLimit)
+        slowest.pop_back();
+}
+
+// Lado escritor del seqlock (solo el worker dueno): version impar, los
+// campos, version par. Los fences ordenan los campos relaxed contra version
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::publishStart(worker_t &w, int64_t start, const char *name)
+{
+    uint64_t v = w.version.load(memory_order_relaxed);
+    w.version.store(v + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    w.taskName.store(name, memory_order_relaxed);
+    w.taskStartNs.store(start, memory_order_relaxed);
+    w.taskSeq.store(w.taskSeq.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    w.version.store(v + 2, memory_order_release);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::publishEnd(worker_t &w, int64_t took)
+{
+    uint64_t v = w.version.load(memory_order_relaxed);
+    w.version.store(v + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    w.lastTaskNs.store(took, memory_order_relaxed);
+    w.taskStartNs.store(0, memory_order_relaxed);
+    w.version.store(v + 2, memory_order_release);
+}
+
+// Muestrea lo que publica cada worker. Si una lectura se cruza con una
+// escritura (version impar o distinta al final) se descarta esa muestra
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::watchdog()
+{
+    typedef struct tracked
+    {
+        bool live = false; // hay una task en seguimiento
+        bool reported = false;
+        uint64_t seq = 0;
+        const char *name = nullptr;
+        int64_t maxElapsedNs = 0;
+    } tracked_t;
+
+    vector<tracked_t> seen(wts.size());
+    auto period = max(chrono::milliseconds(1), stallThreshold / 4);
+    int64_t thresholdNs = chrono::duration_cast<chrono::nanoseconds>(stallThreshold).count();
+
+    unique_lock<mutex> ul(watchdogLock);
+    while (!done)
+    {
+        watchdogWake.wait_for(ul, period);
+        if (done)
+            break;
+
+        int64_t now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        vector<task_report_t> stalls;
+        for (size_t i = 0; i < wts.size(); i++)
+        {
+            worker_t *slot = slotAt(i);
+            if (!slot)
+                continue;
+            worker_t &w = *slot;
+            uint64_t v = w.version.load(memory_order_acquire);
+            if (v & 1)
+                continue;
+            uint64_t seq = w.taskSeq.load(memory_order_relaxed);
+            int64_t start = w.taskStartNs.load(memory_order_relaxed);
+            const char *name = w.taskName.load(memory_order_relaxed);
+            int64_t last = w.lastTaskNs.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if (w.version.load(memory_order_relaxed) != v)
+                continue;
+
+            tracked_t &t = seen[i];
+            if (t.live && (seq != t.seq || start == 0))
+            {
+                // Termino la que seguiamos: si es la ultima tenemos su duracion exacta
+                int64_t elapsed = (seq == t.seq && start == 0) ? last : t.maxElapsedNs;
+                recordSlow(task_report_t{(int)i, t.seq, t.name, chrono::nanoseconds(elapsed)});
+                t.live = false;
+            }
+            if (start == 0)
+                continue;
+
+            if (!t.live)
+                t = tracked_t{true, false, seq, name, 0};
+            t.maxElapsedNs = now - start;
+            if (!t.reported && t.maxElapsedNs > thresholdNs)
+            {
+                t.reported = true;
+                stalls.push_back(task_report_t{(int)i, seq, name, chrono::nanoseconds(t.maxElapsedNs)});
+            }
+        }
+
+        // El callback corre sin el lock, asi puede pedir slowestTasks()
+        if (!stalls.empty() && onStall)
+        {
+            ul.unlock();
+            for (auto &r : stalls)
+                onStall(r);
+            ul.lock();
+        }
+    }
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+bool BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::trySchedule(const function<void(void)> &thunk)
+{
+    if (shedding.load(memory_order_relaxed))
+    {
+        stats.onReject();
+        return false;
+    }
+    schedule(thunk);
+    return true;
+}
+
+// Lo llama el dispatcher con cada task que saca. Como en CoDel, un pico no
+// alcanza: hay sobrecarga cuando el minimo del intervalo queda arriba del target
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::trackSojourn(const job_t &job)
+{
+    auto now = chrono::steady_clock::now();
+    if (now - job.enqueued < sojournTarget)
+    {
+        firstAbove = chrono::steady_clock::time_point();
+        shedding.store(false, memory_order_relaxed);
+    }
+    else if (firstAbove == chrono::steady_clock::time_point())
+    {
+        firstAbove = now + sojournInterval;
+    }
+    else if (now >= firstAbove)
+    {
+        shedding.store(true, memory_order_relaxed);
+    }
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::stage(job_node_t *node)
+{
+    if (done)
+    {
+        freeJobNode(node);
+        throw runtime_error("Cannot schedule task on destroyed ThreadPool");
+    }
+
+    startDispatcher();
+    producer_buffer_t *buf = localBuffer();
+    bool first, full;
+    {
+        lock_guard<mutex> lg(buf->lock);
+        auto now = chrono::steady_clock::now();
+        first = buf->jobs.empty();
+        if (first)
+            buf->oldest = now;
+        buf->jobs.push(node);
+        outstanding.fetch_add(1);
+        stats.onSchedule();
+        stagedTasks++;
+        full = buf->jobs.size() >= batchSize || now - buf->oldest >= maxStageDelay;
+    }
+
+    if (full)
+        publish(*buf, false);
+    else if (first)
+        newTaskSemaphore.signal(); // que el dispatcher arranque el reloj del lote
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+producer_buffer_t *BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::localBuffer()
+{
+    auto it = pool_detail::localBuffers.find(poolId);
+    if (it != pool_detail::localBuffers.end())
+        return it->second;
+
+    // Primera vez que este hilo programa en este pool: de paso se olvida
+    // de los pools que ya no existen
+    pool_detail::dropStaleBuffers();
+    unique_ptr<producer_buffer_t> buf(new producer_buffer_t());
+    producer_buffer_t *raw = buf.get();
+    {
+        lock_guard<mutex> lg(buffersLock);
+        buffers.push_back(move(buf));
+    }
+    pool_detail::localBuffers[poolId] = raw;
+    return raw;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::publish(producer_buffer_t &buf, bool onlyStale)
+{
+    JobQueue batch;
+    {
+        lock_guard<mutex> lg(buf.lock);
+        if (buf.jobs.empty())
+            return;
+        if (onlyStale && chrono::steady_clock::now() - buf.oldest < maxStageDelay)
+            return;
+        batch.splice(buf.jobs);
+    }
+
+    // Un solo pase por la cola y un solo signal por lote
+    size_t n = batch.size();
+    taskQueue.pushChain(batch);
+    stagedTasks -= n;
+    newTaskSemaphore.signal();
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::flushAll(bool onlyStale)
+{
+    lock_guard<mutex> lg(buffersLock);
+    for (auto &buf : buffers)
+    {
+        publish(*buf, onlyStale);
+    }
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::flush()
+{
+    if (batchSize == 0)
+        return;
+    auto it = pool_detail::localBuffers.find(poolId);
+    if (it != pool_detail::localBuffers.end())
+        publish(*it->second, false);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::wait()
+{
+    // Lo que quedo juntado en buffers tambien cuenta
+    if (batchSize > 0)
+        flushAll(false);
+
+    if (outstanding.load() == 0)
+        return;
+
+    // Rondas cortas: girar un rato sale mas barato que dormir en el futex.
+    // El presupuesto crece si el giro viene acertando y se achica si igual
+    // terminamos durmiendo (los wait() largos no queman nada de mas).
+    // Con un solo core no se gira: el que tiene que terminar es el worker
+    bool hit = false;
+    if (!pool_detail::singleCore())
+    {
+        int64_t rate = spinHitRate.load(memory_order_relaxed);
+        int64_t budget = pool_detail::kMinSpinNs +
+                         (pool_detail::kMaxSpinNs - pool_detail::kMinSpinNs) * rate / pool_detail::kSpinRateOne;
+        auto start = chrono::steady_clock::now();
+        for (unsigned spins = 0;; spins++)
+        {
+            if (outstanding.load(memory_order_acquire) == 0)
+            {
+                hit = true;
+                break;
+            }
+            if ((spins & 63) == 0 &&
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count() >= budget)
+                break;
+            cpuRelax();
+        }
+
+        // Promedio movil (1/8) de los aciertos
+        int64_t target = hit ? pool_detail::kSpinRateOne : 0;
+        spinHitRate.store(rate + (target - rate) / 8, memory_order_relaxed);
+    }
+    if (hit)
+        return;
+
+    // Dormir hasta que outstanding llegue a 0
+    waiters.fetch_add(1);
+    {
+        unique_lock<mutex> ul(completionLock);
+        allTasksComplete.wait(ul, [this]()
+                              { return outstanding.load() == 0; });
+    }
+    waiters.fetch_sub(1);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::finishTask()
+{
+    // Solo el que deja outstanding en 0 y con alguien dormido toca el lock
+    if (outstanding.fetch_sub(1) == 1 && waiters.load() > 0)
+    {
+        lock_guard<mutex> lg(completionLock);
+        allTasksComplete.notify_all(); // despertar al wait()
+    }
+}
+
+// Descarta n tasks de una: una sola resta en outstanding pa' todo el lote
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::releaseTasks(size_t n)
+{
+    if (n == 0)
+        return;
+    droppedTasks.fetch_add(n, memory_order_relaxed);
+    if (outstanding.fetch_sub(n) == n && waiters.load() > 0)
+    {
+        lock_guard<mutex> lg(completionLock);
+        allTasksComplete.notify_all();
+    }
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::dispatcher()
+{
+    while (!done)
+    {
+        // Esperar a que lleguen tasks nuevas. Si hay tasks juntadas en
+        // buffers despertamos seguido pa' respetar la cota de latencia
+        if (stagedTasks > 0)
+            newTaskSemaphore.waitFor(maxStageDelay);
+        else
+            WaitPolicy::idle(newTaskSemaphore);
+
+        if (done)
+            break;
+
+        if (stagedTasks > 0)
+            flushAll(true);
+
+        // Procesar todas las tasks disponibles
+        size_t dropped = 0; // descartadas por shutdown(), se sueltan juntas al final
+        while (true)
+        {
+            job_node_t *node;
+            bool skipped;
+
+            // Sacar task de la cola
+            node = taskQueue.pop();
+            if (!node)
+            {
+                // Cola vacia: como en CoDel, se sale del estado de sobrecarga
+                if (admissionControl)
+                {
+                    firstAbove = chrono::steady_clock::time_point();
+                    shedding.store(false, memory_order_relaxed);
+                }
+                break;
+            }
+            if (dropping.load(memory_order_relaxed))
+            {
+                freeJobNode(node);
+                dropped++;
+                continue;
+            }
+            if (admissionControl)
+                trackSojourn(node->job);
+            skipped = node->job.cancelled();
+
+            // Cancelada antes de arrancar: se descarta sin pasar por un worker
+            if (skipped)
+            {
+                freeJobNode(node);
+                stats.onSkip();
+                finishTask();
+                continue;
+            }
+
+            // Task con clave: va a su worker, y si esta ocupado a su backlog
+            if (node->job.affinity >= 0)
+            {
+                dispatchKeyed(node);
+                continue;
+            }
+
+            job_t task = move(node->job);
+            freeJobNode(node); // fuera del lock
+
+            // Buscar un worker libre y esperar si es necesario
+            int workerIndex = -1;
+            {
+                unique_lock<mutex> ul(workerLock);
+                workerAvailable.wait(ul, [this]()
+                                     { return done || dropping ||
+                                              (runningWorkers < workerLimit() &&
+                                               (startedWorkers < wts.size() ||
+                                                any_of(wts.begin(), wts.end(),
+                                                       [](const atomic<worker_t *> &w)
+                                                       {
+                                                           worker_t *p = w.load(memory_order_relaxed);
+                                                           return p && p->available; }))); });
+
+                if (done) // si lo estan cerrando, devuelve la task
+                {
+                    job_node_t *back = allocJobNode();
+                    back->job = move(task);
+                    taskQueue.push(back);
+                    break;
+                }
+                if (dropping) // la que teniamos en la mano tambien se descarta
+                {
+                    dropped++;
+                    continue;
+                }
+
+                // Asignar task al primer worker disponible
+                for (size_t i = 0; i < wts.size(); i++)
+                {
+                    worker_t *w = slotAt(i);
+                    if (w && w->available)
+                    {
+                        w->available = false;
+                        idleWorkers--;
+                        w->assigned = true;
+                        runningWorkers++;
+                        w->job = move(task); // asigno task
+                        workerIndex = i;
+                        break;
+                    }
+                }
+
+                // Nadie libre pero quedan hilos sin crear: arrancar uno con esta task
+                for (size_t i = 0; workerIndex == -1 && i < wts.size(); i++)
+                {
+                    worker_t *w = slotAt(i);
+                    if (!w || !w->started)
+                    {
+                        worker_t &started = startWorker(i);
+                        started.assigned = true;
+                        runningWorkers++;
+                        started.job = move(task);
+                        workerIndex = i;
+                    }
+                }
+            }
+
+            if (workerIndex == -1)
+                continue;
+
+            // Cola profunda: de paso le dejamos un lote en su worker, asi lo
+            // corre sin volver a pasar por el dispatcher ni por el semaforo.
+            // Va antes del signal: el worker todavia no puede estar libre
+            JobQueue batch;
+            for (size_t extra = deliveryBatch(); extra > 1; extra--)
+            {
+                job_node_t *more = taskQueue.pop();
+                if (!more)
+                    break;
+                if (dropping.load(memory_order_relaxed))
+                {
+                    freeJobNode(more);
+                    dropped++;
+                    continue;
+                }
+                if (admissionControl)
+                    trackSojourn(more->job);
+                if (more->job.affinity >= 0)
+                {
+                    dispatchKeyed(more);
+                    continue;
+                }
+                batch.push(more); // las canceladas las saltea el worker
+            }
+            if (!batch.empty())
+            {
+                lock_guard<mutex> lg(workerLock);
+                while (job_node_t *more = batch.pop())
+                    slotAt(workerIndex)->batch.push(more);
+            }
+
+            // Despertar al worker para la task
+            slotAt(workerIndex)->taskReady.signal();
+        }
+        releaseTasks(dropped);
+    }
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::dispatchKeyed(job_node_t *node)
+{
+    int target = node->job.affinity;
+    worker_t *w = nullptr;
+    {
+        lock_guard<mutex> lg(workerLock);
+        w = slotAt(target);
+        if (w && !w->available && w->backlog.size() >= pool_detail::kStealThreshold)
+        {
+            // Shard sobrecargado: si hay alguien libre (o sin arrancar) que se la lleve
+            for (size_t i = 0; i < baseWorkers; i++)
+            {
+                worker_t *other = slotAt(i);
+                if (!other || other->available || !other->started)
+                {
+                    target = i;
+                    w = other;
+                    break;
+                }
+            }
+        }
+
+        if (!w || !w->started)
+        {
+            w = &startWorker(target); // arranca directo con esta task
+        }
+        else if (!w->available)
+        {
+            w->backlog.push(node); // la agarra cuando termine lo que esta haciendo
+            return;
+        }
+        else
+        {
+            w->available = false;
+            idleWorkers--;
+        }
+        w->assigned = true;
+        runningWorkers++;
+        w->job = move(node->job);
+    }
+
+    freeJobNode(node);
+    w->taskReady.signal();
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+job_node_t *BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::nextLocalJob(int id)
+{
+    // Primero lo propio, despues los lotes ajenos (sin clave: se roban aunque
+    // quede una sola) y por ultimo el backlog con clave mas cargado
+    worker_t &me = *slotAt(id);
+    job_node_t *next = me.backlog.pop();
+    if (!next)
+        next = me.batch.pop();
+    if (next)
+        return next;
+
+    worker_t *victim = nullptr;
+    size_t biggest = 0;
+    for (size_t i = 0; i < wts.size(); i++)
+    {
+        worker_t *w = slotAt(i);
+        if (w && w->batch.size() > biggest)
+        {
+            biggest = w->batch.size();
+            victim = w;
+        }
+    }
+    if (victim)
+        return victim->batch.pop();
+
+    size_t longest = pool_detail::kStealThreshold - 1;
+    for (size_t i = 0; i < wts.size(); i++)
+    {
+        worker_t *w = slotAt(i);
+        if (w && w->backlog.size() > longest)
+        {
+            longest = w->backlog.size();
+            victim = w;
+        }
+    }
+    return victim ? victim->backlog.pop() : nullptr;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+int BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::currentWorkerId() const
+{
+    return pool_detail::currentPool == this ? pool_detail::currentWorker : -1;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+Arena &BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::currentWorkerArena()
+{
+    if (!pool_detail::currentArena)
+    {
+        throw runtime_error("currentWorkerArena() called outside a pool worker");
+    }
+    return *pool_detail::currentArena;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+template <typename F, typename G>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::invoke(F &&f, G &&g)
+{
+    if (pool_detail::isNullCallable(f) || pool_detail::isNullCallable(g))
+    {
+        throw invalid_argument("Cannot invoke null function");
+    }
+
+    // g se queda donde esta (en el stack del que invoca): el frame solo
+    // guarda la direccion y como llamarla, sin alocar nada
+    typedef remove_reference_t<G> g_t;
+    fork_frame_t fr;
+    fr.g = const_cast<void *>(static_cast<const void *>(addressof(g)));
+    fr.call = [](void *p)
+    { (*static_cast<g_t *>(p))(); };
+    int id = currentWorkerId();
+
+    // Desde afuera del pool no hay deque propio: g va por la cola comun
+    if (id < 0)
+    {
+        Semaphore finished;
+        schedule([this, &fr, &finished]()
+                 {
+            fr.state = kForkTaken;
+            runFork(fr);
+            finished.signal(); });
+
+        exception_ptr ferr;
+        try
+        {
+            f();
+        }
+        catch (...)
+        {
+            ferr = current_exception();
+        }
+        finished.wait();
+        if (ferr)
+            rethrow_exception(ferr);
+        if (fr.error)
+            rethrow_exception(fr.error);
+        return;
+    }
+
+    // g queda a la vista en nuestro deque mientras corremos f
+    worker_t &me = *slotAt(id);
+    {
+        lock_guard<mutex> lg(me.forkLock);
+        me.forks.push_back(&fr);
+    }
+
+    // Solo pasamos por la cola global si hay alguien libre pa' robar
+    if (idleWorkers.load(memory_order_relaxed) > 0 || startedWorkers.load(memory_order_relaxed) < baseWorkers)
+    {
+        schedule([this]()
+                 {
+            fork_frame_t *stolen = stealFork(currentWorkerId());
+            if (stolen)
+                runFork(*stolen); });
+    }
+
+    exception_ptr ferr;
+    try
+    {
+        f();
+    }
+    catch (...)
+    {
+        ferr = current_exception();
+    }
+
+    // Si nadie se la llevo sigue arriba de todo (LIFO): la corremos aca mismo
+    bool mine = false;
+    {
+        lock_guard<mutex> lg(me.forkLock);
+        if (!me.forks.empty() && me.forks.back() == &fr)
+        {
+            me.forks.pop_back();
+            mine = true;
+        }
+    }
+
+    if (mine)
+    {
+        fr.state = kForkTaken;
+        runFork(fr);
+    }
+    else
+    {
+        // Nos la robaron: en vez de bloquear el worker ayudamos con otras
+        while (fr.state.load(memory_order_acquire) != kForkDone)
+        {
+            fork_frame_t *other = stealFork(id);
+            if (other)
+                runFork(*other);
+            else
+                this_thread::yield();
+        }
+    }
+
+    if (ferr)
+        rethrow_exception(ferr);
+    if (fr.error)
+        rethrow_exception(fr.error);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+fork_frame_t *BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::stealFork(int self)
+{
+    // Se roba por abajo (lo mas viejo = el pedazo mas grande de trabajo)
+    size_t n = wts.size();
+    size_t start = self >= 0 ? self + 1 : 0;
+    for (size_t k = 0; k < n; k++)
+    {
+        worker_t *w = slotAt((start + k) % n);
+        if (!w)
+            continue;
+        lock_guard<mutex> lg(w->forkLock);
+        if (!w->forks.empty())
+        {
+            fork_frame_t *fr = w->forks.front();
+            w->forks.pop_front();
+            fr->state = kForkTaken;
+            return fr;
+        }
+    }
+    return nullptr;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::runFork(fork_frame_t &fr)
+{
+    try
+    {
+        fr.call(fr.g);
+    }
+    catch (...)
+    {
+        fr.error = current_exception();
+    }
+    fr.state.store(kForkDone, memory_order_release);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::worker(int id)
+{
+    pool_detail::currentPool = this;
+    pool_detail::currentWorker = id;
+    worker_t &me = *slotAt(id); // lo armo startWorker antes de crear el hilo
+    pool_detail::currentArena = &me.arena;
+
+    while (!done)
+    {
+        // Esperar a task
+        WaitPolicy::idle(me.taskReady);
+
+        if (done || me.retiring)
+            break;
+
+        // Ejecutar la task asignada y despues lo que haya en el backlog
+        if (me.assigned)
+        {
+            // Se mide la tanda entera (dos lecturas del reloj por despertada)
+            // pa' que el dispatcher sepa de que tamanio armar los lotes
+            auto burstStart = chrono::steady_clock::now();
+            int64_t burstTasks = 0;
+            while (true)
+            {
+                if (!me.job.cancelled()) // la pudieron cancelar mientras esperaba worker
+                {
+                    if (watchdogOn.load(memory_order_relaxed))
+                    {
+                        // Publicar la task pa' el watchdog: solo stores, sin locks
+                        int64_t start = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+                        publishStart(me, start, me.job.name);
+                        me.job.run();
+                        int64_t end = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+                        publishEnd(me, end - start);
+                    }
+                    else
+                    {
+                        me.job.run();
+                    }
+                    stats.onComplete();
+                    if (closing.load(memory_order_relaxed))
+                        closingCompleted.fetch_add(1, memory_order_relaxed);
+                }
+                else
+                {
+                    stats.onSkip();
+                }
+                me.job = job_t(); // soltar las capturas ya
+                me.arena.reset();  // los temporales de la task se van todos juntos
+                burstTasks++;
+
+                // Si no queda nada local nos marcamos como disponibles y avisamos
+                job_node_t *next;
+                {
+                    lock_guard<mutex> workerGuard(workerLock);
+                    next = nextLocalJob(id);
+                    if (!next)
+                    {
+                        me.available = true; // ya estamos libres
+                        idleWorkers++;
+                        me.assigned = false; // sin task asignada
+                        runningWorkers--;
+                        retireExtraWorkers(); // si sobramos, nos vamos
+                        // Avisar al dispatcher que hay worker libre
+                        workerAvailable.notify_one();
+                    }
+                }
+
+                // Decrementar contador de tasks pendientes - DESPUeS de ejecutar
+                finishTask();
+
+                if (!next)
+                {
+                    int64_t took = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - burstStart).count();
+                    int64_t avg = avgTaskNs.load(memory_order_relaxed);
+                    avgTaskNs.store(avg + (took / burstTasks - avg) / 8, memory_order_relaxed);
+                    break;
+                }
+                me.job = move(next->job);
+                freeJobNode(next);
+            }
+        }
+    }
+}
+
+// Cuantas tasks entregar de una al worker elegido: nada de lotes con la cola
+// corta, nunca mas que su parte de la cola (los otros workers tambien comen)
+// y no mas de kBatchBudgetNs de laburo segun lo que vienen durando las tasks
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+size_t BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::deliveryBatch()
+{
+    // Con cola acotada cada task sacada libera lugar: en lotes el
+    // backpressure se correria al batch de cada worker
+    if constexpr (QueuePolicy::kBounded)
+        return 1;
+
+    size_t depth = taskQueue.size();
+    if (depth < baseWorkers * 2)
+        return 1;
+
+    size_t share = depth / baseWorkers;
+    int64_t avg = max<int64_t>(avgTaskNs.load(memory_order_relaxed), 1);
+    size_t byTime = max<int64_t>(pool_detail::kBatchBudgetNs / avg, 1);
+    return min({share, byTime, pool_detail::kMaxBatch});
+}
+
+// Cuantos workers pueden tener task a la vez: los de siempre mas uno por
+// cada task metida en un blocking_region
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+size_t BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::workerLimit() const
+{
+    return min(baseWorkers + blockedWorkers, wts.size());
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::blocking_region::blocking_region(BasicThreadPool &pool)
+    : pool(pool.currentWorkerId() >= 0 ? &pool : nullptr)
+{
+    if (this->pool)
+        this->pool->enterBlocking();
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::blocking_region::~blocking_region()
+{
+    if (pool)
+        pool->leaveBlocking();
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::enterBlocking()
+{
+    // El lote que nos dejo el dispatcher no se queda esperando atras de
+    // nosotros: vuelve a la cola pa' que lo agarre otro worker
+    JobQueue returned;
+    {
+        lock_guard<mutex> lg(workerLock);
+        blockedWorkers++;
+        // El lugar del que nos compensa se arma recien ahora que hace falta
+        if (baseWorkers + blockedWorkers <= wts.size())
+            buildSlot(baseWorkers + blockedWorkers - 1);
+        returned.splice(slotAt(currentWorkerId())->batch);
+        // Si hay tasks esperando worker, el dispatcher ya puede usar uno mas
+        workerAvailable.notify_one();
+    }
+    if (!returned.empty())
+    {
+        taskQueue.pushChain(returned);
+        newTaskSemaphore.signal();
+    }
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::leaveBlocking()
+{
+    lock_guard<mutex> lg(workerLock);
+    blockedWorkers--;
+    retireExtraWorkers();
+}
+
+// Con workerLock tomado: despide workers de compensacion libres mientras
+// haya mas hilos que los que hacen falta. Los de siempre nunca se retiran
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::retireExtraWorkers()
+{
+    for (size_t i = wts.size(); i > baseWorkers && startedWorkers > workerLimit(); i--)
+    {
+        worker_t *w = slotAt(i - 1);
+        if (!w || !w->started || !w->available)
+            continue;
+        w->available = false;
+        idleWorkers--;
+        w->started = false;
+        startedWorkers--;
+        w->retiring = true;
+        w->taskReady.signal(); // se despierta, ve retiring y termina el hilo
+    }
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+shutdown_report_t BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::shutdown(shutdown_mode mode, chrono::milliseconds deadline)
+{
+    if (currentWorkerId() >= 0)
+    {
+        throw runtime_error("Cannot shut down ThreadPool from one of its workers");
+    }
+    if (closing.exchange(true))
+    {
+        throw runtime_error("ThreadPool already shut down");
+    }
+
+    if (batchSize > 0)
+        flushAll(false); // lo juntado en buffers entra a la cola (y se descarta ahi)
+
+    if (mode == kShutdownCancelPending)
+        dropPending();
+    else if (mode == kShutdownDeadline && !waitUntil(chrono::steady_clock::now() + deadline))
+        dropPending();
+
+    // Queda lo que esta corriendo (o todo, si es drain)
+    wait();
+    stopThreads();
+    return shutdown_report_t{closingCompleted.load(), droppedTasks.load()};
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::dropPending()
+{
+    dropping = true;
+
+    // Los backlogs con clave y los lotes se sueltan aca mismo, enteros
+    size_t n = 0;
+    {
+        lock_guard<mutex> lg(workerLock);
+        for (size_t i = 0; i < wts.size(); i++)
+        {
+            worker_t *w = slotAt(i);
+            if (!w)
+                continue;
+            while (job_node_t *node = w->backlog.pop())
+            {
+                freeJobNode(node);
+                n++;
+            }
+            while (job_node_t *node = w->batch.pop())
+            {
+                freeJobNode(node);
+                n++;
+            }
+        }
+        workerAvailable.notify_all(); // el dispatcher suelta la que tiene en la mano
+    }
+    releaseTasks(n);
+
+    // La cola la vacia el dispatcher, que es el unico que saca de ahi
+    newTaskSemaphore.signal();
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+bool BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::waitUntil(chrono::steady_clock::time_point deadline)
+{
+    waiters.fetch_add(1);
+    bool finished;
+    {
+        unique_lock<mutex> ul(completionLock);
+        finished = allTasksComplete.wait_until(ul, deadline, [this]()
+                                               { return outstanding.load() == 0; });
+    }
+    waiters.fetch_sub(1);
+    return finished;
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::~BasicThreadPool()
+{
+    // Esperar que terminen todas las tasks programadas, si no lo cerraron antes
+    if (!closing)
+        shutdown(kShutdownDrain);
+    pool_detail::retirePoolId(poolId);
+
+    for (size_t i = 0; i < wts.size(); i++)
+        delete slotAt(i);
+}
+
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+void BasicThreadPool<QueuePolicy, WaitPolicy, StatsPolicy>::stopThreads()
+{
+    done = true;
+
+    // Despertar al dispatcher
+    newTaskSemaphore.signal();
+
+    // Frenar al watchdog
+    {
+        lock_guard<mutex> lg(watchdogLock);
+        watchdogWake.notify_all();
+    }
+    if (wd.joinable())
+    {
+        wd.join();
+    }
+
+    // Despertar workers que esperan disponibilidad
+    {
+        lock_guard<mutex> lg(workerLock);
+        workerAvailable.notify_all();
+    }
+
+    // Despertar a todos los workers
+    for (size_t i = 0; i < wts.size(); i++)
+    {
+        if (worker_t *w = slotAt(i))
+            w->taskReady.signal();
+    }
+
+    // Hacer join de todos los hilos
+    if (dt.joinable()) // el dispatcher
+    {
+        dt.join();
+    }
+
+    for (size_t i = 0; i < wts.size(); i++) // todos los workers
+    {
+        worker_t *w = slotAt(i);
+        if (w && w->ts.joinable())
+        {
+            w->ts.join();
+        }
+    }
+}
+
+#endif
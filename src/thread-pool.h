@@ -6,54 +6,418 @@
 #include <thread>
 #include <atomic>
 #include <vector>
-#include <queue>
 #include <mutex> // la 'talking pillow' xd (S01, E04 para cultos)
 #include <condition_variable>
+#include <coroutine>
+#include <chrono>
+#include <memory>
+#include <deque>
+#include <exception>
+#include <unordered_map>
+#include <type_traits>
 #include "Semaphore.h"
+#include "cancellation.h"
+#include "job-queue.h"
+#include "pool-policies.h"
+#include "arena.h"
 
 using namespace std;
 
+// Rama g de un invoke(f, g): vive en el stack del que invoca
+enum fork_state
+{
+  kForkPending,
+  kForkTaken,
+  kForkDone
+};
+
+typedef struct fork_frame
+{
+  void *g = nullptr;               // el callable, tal cual lo paso el que invoca
+  void (*call)(void *g) = nullptr; // lo llama sin envolverlo en function
+  atomic<int> state{kForkPending};
+  exception_ptr error;
+} fork_frame_t;
+
 // Un worker que labura en el thread pool
 typedef struct worker
 {
   thread ts;
-  function<void(void)> thunk; // la task
+  job_t job; // la task
+  JobQueue backlog; // tasks con clave que esperan a este worker (bajo workerLock)
+  JobQueue batch; // lote que le dejo el dispatcher, se lo puede robar cualquiera (bajo workerLock)
+  mutex forkLock;
+  deque<fork_frame_t *> forks; // LIFO pa' su worker, los ladrones sacan del otro lado
   bool available;
   bool assigned;
+  bool started; // el hilo se crea recien cuando hace falta
+  bool retiring; // worker de compensacion que sobra: al despertar se va
   int id;
   Semaphore taskReady; // para avisarle
+  Arena arena; // memoria temporal de las tasks, se resetea despues de cada una
+
+  // Lo que muestrea el watchdog, sin tomar workerLock (solo con watchdog).
+  // Se publica estilo seqlock: version es impar mientras el worker escribe
+  atomic<uint64_t> version{0};
+  atomic<uint64_t> taskSeq{0};           // tasks arrancadas por este worker
+  atomic<int64_t> taskStartNs{0};        // cuando arranco la actual, 0 = ninguna
+  atomic<const char *> taskName{nullptr};
+  atomic<int64_t> lastTaskNs{0};         // cuanto duro la ultima que termino
 } worker_t;
 
-class ThreadPool
+// Como cerrar el pool con shutdown()
+enum shutdown_mode
+{
+  kShutdownDrain,         // correr todo lo programado (lo que hace el destructor)
+  kShutdownCancelPending, // descartar lo que no arranco y esperar lo que corre
+  kShutdownDeadline,      // drenar hasta el deadline y despues descartar el resto
+};
+
+// Lo que paso durante un shutdown()
+typedef struct shutdown_report
+{
+  size_t completed; // tasks que terminaron de correr mientras se cerraba
+  size_t dropped;   // descartadas sin correr
+} shutdown_report_t;
+
+// Que hace schedule() cuando el pool esta saturado (ningun worker libre
+// y la cola ya tiene al menos maxQueueDepth tasks)
+enum saturation_mode
+{
+  kSaturationEnqueue,     // encolar igual (lo de siempre)
+  kSaturationCallerRuns,  // correrla en el hilo que la programa
+  kSaturationInlineCheap, // correrla ahi solo si se programo como kTaskCheap
+};
+
+// Pista del que programa sobre cuanto cuesta la task
+enum task_hint
+{
+  kTaskNormal,
+  kTaskCheap, // tan corta que encolarla cuesta mas que correrla
+};
+
+// Una task vista por el watchdog: worker + numero de task en ese worker
+typedef struct task_report
+{
+  int worker;
+  uint64_t task;
+  const char *name; // nullptr si se programo sin nombre
+  chrono::nanoseconds elapsed;
+} task_report_t;
+
+// Buffer de un productor: junta tasks y las publica de a lotes
+typedef struct producer_buffer
+{
+  mutex lock; // casi nunca compartido, solo con los flush del pool
+  JobQueue jobs;
+  chrono::steady_clock::time_point oldest; // cuando entro la primera del lote
+} producer_buffer_t;
+
+// Estado compartido por todas las instancias del template (thread-pool.cc)
+namespace pool_detail
+{
+  // Con este backlog un worker libre ya le puede robar tasks con clave a su worker
+  constexpr size_t kStealThreshold = 4;
+
+  // Cotas del giro adaptativo de wait(), en nanosegundos. El presupuesto va
+  // entre las dos segun la tasa de aciertos del giro (en 1/kSpinRateOne)
+  constexpr int64_t kMinSpinNs = 1000;
+  constexpr int64_t kMaxSpinNs = 50000;
+  constexpr int64_t kSpinRateOne = 1024;
+
+  // Con un solo core girar solo le quita el core al worker que esperamos
+  bool singleCore();
+
+  // Lotes del dispatcher: a lo sumo kMaxBatch tasks y unos kBatchBudgetNs de
+  // laburo por entrega, pa' no dejar tasks atrapadas detras de una lenta
+  constexpr size_t kMaxBatch = 32;
+  constexpr int64_t kBatchBudgetNs = 50000;
+
+  // Id unico por pool, pa' los buffers thread_local. El destructor lo da de
+  // baja y cada hilo barre sus entradas viejas al registrar un buffer nuevo
+  uint64_t newPoolId();
+  void retirePoolId(uint64_t id);
+  void dropStaleBuffers();
+
+  // Buffers de productor de este hilo, uno por pool (los ids no se reusan)
+  extern thread_local unordered_map<uint64_t, producer_buffer_t *> localBuffers;
+
+  // Lambdas y functores que schedule(F&&) construye directo en el nodo.
+  // function sigue por su overload (ahi ya esta la copia hecha) y las
+  // corutinas por el suyo (coroutine_handle tambien se puede llamar)
+  template <typename F>
+  constexpr bool kPlainCallable = is_class_v<decay_t<F>> &&
+                                  is_invocable_r_v<void, decay_t<F> &> &&
+                                  !is_same_v<decay_t<F>, function<void(void)>> &&
+                                  !is_convertible_v<decay_t<F>, coroutine_handle<>>;
+
+  // true si c es un function (o puntero) vacio; las lambdas nunca lo son
+  template <typename F>
+  bool isNullCallable(const F &c)
+  {
+    if constexpr (is_constructible_v<bool, const F &>)
+      return !static_cast<bool>(c);
+    else
+      return false;
+  }
+
+  // Pool y worker del hilo actual (nullptr / -1 si no es un worker)
+  extern thread_local const void *currentPool;
+  extern thread_local int currentWorker;
+  extern thread_local Arena *currentArena;
+}
+
+// El pool en si, armado por politicas que se eligen en compilacion:
+//   QueuePolicy: MutexQueue, LockFreeQueue o BoundedQueue<N>
+//   WaitPolicy:  BlockingWait o SpinWait (como esperan los hilos ociosos)
+//   StatsPolicy: NoStats o CountingStats
+// ThreadPool es la combinacion de siempre
+template <typename QueuePolicy, typename WaitPolicy, typename StatsPolicy>
+class BasicThreadPool
 {
 public:
-  // Crea un pool con la cantidad de hilos que quieras
-  ThreadPool(size_t numThreads);
+  // Crea un pool con hasta numThreads hilos. No arranca ninguno todavia:
+  // el dispatcher y los workers se crean a medida que llega trabajo.
+  // maxThreads es el tope contando los de compensacion de blocking_region
+  // (0 = el doble de numThreads). Solo se reservan punteros: cada worker se
+  // arma cuando arranca, y los de compensacion cuando una task bloquea
+  BasicThreadPool(size_t numThreads, size_t maxThreads = 0);
 
   // Programa una task pa' que la ejecute algun worker
   void schedule(const function<void(void)> &thunk);
 
+  // Igual, pero la lambda se construye directo en el nodo de la cola: si sus
+  // capturas entran en InlineThunk::kInlineSize no se aloca nada por task
+  template <typename F, typename = enable_if_t<pool_detail::kPlainCallable<F>>>
+  void schedule(F &&fn);
+
+  // Igual pero la task se saltea si cancelan el token antes de que arranque
+  void schedule(const function<void(void)> &thunk, const CancellationToken &token);
+
+  // Las tasks con la misma clave van siempre al mismo worker, asi su working
+  // set queda caliente en ese core. Si el shard se sobrecarga, los workers
+  // libres le roban tasks (no garantiza orden entre tasks de una clave).
+  // Tira invalid_argument si el pool se creo sin workers
+  void scheduleOn(size_t key, const function<void(void)> &thunk);
+
+  // Fork-join: corre f aca mismo y deja g en el deque del worker pa' que la
+  // robe alguien libre. Si nadie la roba se corre inline despues de f, asi
+  // la recursion cuesta casi lo mismo que secuencial con todos los cores ocupados
+  template <typename F, typename G>
+  void invoke(F &&f, G &&g);
+
+  // Id del worker de este pool que esta corriendo el hilo actual, o -1
+  int currentWorkerId() const;
+
+  // Arena del worker que esta corriendo la task actual. Lo que se pida ahi
+  // vale hasta que termine la task (ojo con corutinas que cambian de hilo).
+  // Tira runtime_error si el hilo no es un worker
+  static Arena &currentWorkerArena();
+
+  // RAII pa' cuando la task actual va a bloquear (un lock ajeno, I/O).
+  // Mientras dura, el pool puede arrancar un worker de compensacion pa'
+  // mantener el paralelismo (hasta maxThreads); cuando la task
+  // vuelve, el que sobra se retira apenas queda libre. Fuera de un worker
+  // del pool no hace nada
+  class blocking_region
+  {
+  public:
+    blocking_region(BasicThreadPool &pool);
+    ~blocking_region();
+
+  private:
+    BasicThreadPool *pool; // nullptr si no estamos en un worker suyo
+
+    blocking_region(const blocking_region &original) = delete;
+    blocking_region &operator=(const blocking_region &rhs) = delete;
+  };
+
+  // Workers pedidos en el constructor (el paralelismo normal del pool)
+  size_t size() const { return baseWorkers; }
+
+  // Lugares de worker contando los de compensacion: los ids de worker van
+  // de 0 a maxWorkers() - 1 (pa' lo que guarda algo por worker)
+  size_t maxWorkers() const { return wts.size(); }
+
+  // Hilos worker vivos ahora mismo
+  size_t liveWorkers() const { return startedWorkers.load(); }
+
+  // Lugares de worker ya armados: cada uno se arma cuando arranca su hilo
+  size_t builtWorkers() const { return builtSlots.load(); }
+
+  // Tasks programadas que todavia no terminaron (en buffers, en cola o corriendo)
+  size_t pending() const { return outstanding.load(memory_order_acquire); }
+
+  // Awaitable pa' corutinas: co_await pool.schedule() sigue en un worker
+  struct ScheduleAwaiter
+  {
+    BasicThreadPool *pool;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(coroutine_handle<> h) { pool->schedule(h); }
+    void await_resume() const noexcept {}
+  };
+  ScheduleAwaiter schedule() { return ScheduleAwaiter{this}; }
+
+  // Encola una corutina suspendida tal cual, sin envolverla en un thunk
+  void schedule(coroutine_handle<> handle);
+
+  // Opt-in: cada hilo productor junta sus tasks en un buffer propio y las
+  // pasa a la cola de a batchSize, o cuando la mas vieja lleva maxDelay.
+  // Llamarlo antes de empezar a programar tasks
+  void enableProducerBuffers(size_t batchSize, chrono::microseconds maxDelay);
+
+  // Publica ya lo que tenga juntado el hilo que llama
+  void flush();
+
+  // Admission control estilo CoDel: si el tiempo en cola de las tasks se
+  // queda arriba de target durante todo un interval, el pool pasa a estar
+  // sobrecargado y trySchedule() rechaza hasta que el tiempo en cola baje.
+  // schedule() nunca rechaza. Llamarlo antes de empezar a programar tasks
+  void enableAdmissionControl(chrono::microseconds target, chrono::microseconds interval);
+
+  // Igual pero diciendo cuanto cuesta, pa' kSaturationInlineCheap
+  void schedule(const function<void(void)> &thunk, task_hint hint);
+
+  // Con el pool saturado, schedule() puede correr la task ahi mismo en vez
+  // de encolarla: asi los productores se frenan solos en vez de llenar la
+  // cola. Si la task corre inline sus excepciones le llegan al que programa.
+  // Vale pa' todos los schedule() de thunks (con nombre, token o hint) y
+  // trySchedule(); no pa' scheduleOn(), que promete su worker, ni pa' las
+  // corutinas, que se encolan justamente pa' seguir en un worker.
+  // maxQueueDepth cuenta todo lo que espera worker: la cola, los buffers de
+  // productor y lo que ya se repartio en lotes o backlogs con clave
+  void setSaturationPolicy(saturation_mode mode, size_t maxQueueDepth);
+
+  // Igual que schedule() pero con nombre pa' los reportes del watchdog.
+  // name tiene que vivir tanto como el pool (un literal, por ejemplo)
+  void schedule(const function<void(void)> &thunk, const char *name);
+
+  // Opt-in: un hilo watchdog mira cada threshold/4 la task que corre cada
+  // worker y llama onStall (desde su hilo, una vez por task) con las que
+  // pasan threshold. Ademas guarda las topN tasks mas lentas que vio
+  // (es muestreo: las mas cortas que el periodo pueden no aparecer)
+  void enableWatchdog(chrono::milliseconds threshold,
+                      const function<void(const task_report_t &)> &onStall,
+                      size_t topN = 10);
+
+  // Las tasks mas lentas vistas por el watchdog, de mayor a menor
+  vector<task_report_t> slowestTasks();
+
+  // Task de baja prioridad: devuelve false (y no la programa) si hay sobrecarga
+  bool trySchedule(const function<void(void)> &thunk);
+
+  // true mientras el admission control este rechazando
+  bool overloaded() const { return shedding; }
+
   // Espera a que terminen todas las tasks
   void wait();
 
+  // Cierra el pool y frena los hilos; despues schedule() tira. Mientras se
+  // cierra las tasks que corren pueden seguir programando (si se descarta,
+  // eso tambien se descarta). Lo que ya le llego a un worker corre igual, y
+  // las corutinas descartadas no se retoman. No llamarlo desde un worker
+  shutdown_report_t shutdown(shutdown_mode mode, chrono::milliseconds deadline = chrono::milliseconds(0));
+
+  // Metricas de la StatsPolicy (vacias con NoStats)
+  const StatsPolicy &statistics() const { return stats; }
+
   // Destructor que limpia todo bien
-  ~ThreadPool();
+  ~BasicThreadPool();
 
 private:
   void worker(int id);
   void dispatcher();
+  void enqueue(job_node_t *node);
+  void dispatchKeyed(job_node_t *node);
+  job_node_t *nextLocalJob(int id);
+  fork_frame_t *stealFork(int self);
+  void runFork(fork_frame_t &fr);
+  void finishTask();
+  void startDispatcher();
+  worker_t &buildSlot(size_t i);
+  worker_t &startWorker(size_t i);
+  worker_t *slotAt(size_t i) const { return wts[i].load(memory_order_acquire); }
+  void stage(job_node_t *node);
+  producer_buffer_t *localBuffer();
+  void publish(producer_buffer_t &buf, bool onlyStale);
+  void flushAll(bool onlyStale);
+  void trackSojourn(const job_t &job);
+  size_t workerLimit() const;
+  size_t deliveryBatch();
+  void enterBlocking();
+  void leaveBlocking();
+  void retireExtraWorkers();
+  void watchdog();
+  void publishStart(worker_t &w, int64_t start, const char *name);
+  void publishEnd(worker_t &w, int64_t took);
+  void dropPending();
+  bool runInline(job_node_t *node);
+  void releaseTasks(size_t n);
+  bool waitUntil(chrono::steady_clock::time_point deadline);
+  void stopThreads();
+  void recordSlow(const task_report_t &report);
   thread dt;            // hilo para tasks
-  vector<worker_t> wts; // todos los workers
-  mutex queueLock;
-  queue<function<void(void)>> taskQueue; // pendientes
+  vector<atomic<worker_t *>> wts; // un lugar por worker, nullptr hasta que arranca (son del pool)
+  QueuePolicy taskQueue; // pendientes, nodos reciclados
   Semaphore newTaskSemaphore;
   mutex workerLock;
   condition_variable workerAvailable;  // libera notification
-  int activeTasks;                     // cuantas rn
+  atomic<size_t> outstanding;          // programadas y sin terminar (juntadas + en cola + corriendo)
+  atomic<int> waiters;                 // wait() dormidos en allTasksComplete
+  atomic<int64_t> spinHitRate;         // que tan seguido el giro de wait() llega a ver el 0
+  atomic<int64_t> avgTaskNs;           // cuanto vienen durando las tasks, pa' los lotes
+  mutex completionLock;                // solo pa' dormir/despertar wait()
   condition_variable allTasksComplete; // wake up
   atomic<bool> done;
+  [[no_unique_address]] StatsPolicy stats;
+
+  uint64_t poolId;                             // unico por pool, pa' los buffers thread_local
+  atomic<size_t> batchSize;                    // 0 = sin buffers de productor
+  chrono::microseconds maxStageDelay;          // cota de latencia de lo juntado
+  atomic<size_t> stagedTasks;                  // en buffers, todavia no en la cola
+  atomic<int> idleWorkers;                     // workers con available = true
+  atomic<size_t> startedWorkers;               // hilos worker ya creados
+  atomic<size_t> builtSlots;                   // lugares de wts ya armados
+  size_t baseWorkers;                          // los pedidos en el constructor
+  size_t runningWorkers;                       // con task asignada (bajo workerLock)
+  size_t blockedWorkers;                       // en un blocking_region (bajo workerLock)
+  once_flag dispatcherOnce;                    // el dispatcher arranca con la primera task
+  mutex buffersLock;                           // protege buffers
+  vector<unique_ptr<producer_buffer_t>> buffers; // uno por hilo productor
 
-  ThreadPool(const ThreadPool &original) = delete;
-  ThreadPool &operator=(const ThreadPool &rhs) = delete;
+  atomic<bool> admissionControl;               // se estampa el enqueue de cada task
+  chrono::nanoseconds sojournTarget;           // tiempo en cola aceptable
+  chrono::nanoseconds sojournInterval;         // cuanto tiene que durar el exceso
+  chrono::steady_clock::time_point firstAbove; // fin del intervalo en curso (solo el dispatcher)
+  atomic<bool> shedding;                       // sobrecargado: trySchedule rechaza
+
+  thread wd;                                   // hilo watchdog (si se pidio)
+  atomic<bool> watchdogOn;                     // los workers publican sus tasks
+  chrono::milliseconds stallThreshold;
+  function<void(const task_report_t &)> onStall;
+  size_t slowestLimit;
+  mutex watchdogLock;                          // el del watchdog, nunca workerLock
+  condition_variable watchdogWake;             // pa' frenarlo en el destructor
+  vector<task_report_t> slowest;               // top-N, de mayor a menor
+
+  atomic<int> saturationMode;                  // un saturation_mode
+  atomic<size_t> saturationDepth;              // cola a partir de la cual hay saturacion
+
+  atomic<bool> closing;                        // shutdown() empezo
+  atomic<bool> dropping;                       // se descarta lo que no arranco
+  atomic<size_t> closingCompleted;             // terminadas desde que empezo el shutdown
+  atomic<size_t> droppedTasks;
+
+  BasicThreadPool(const BasicThreadPool &original) = delete;
+  BasicThreadPool &operator=(const BasicThreadPool &rhs) = delete;
 };
+
+// El pool de siempre: cola con mutex, hilos que duermen, sin metricas
+typedef BasicThreadPool<MutexQueue, BlockingWait, NoStats> ThreadPool;
+
+#include "thread-pool-impl.h"
+
+// ThreadPool se instancia una sola vez en thread-pool.cc
+extern template class BasicThreadPool<MutexQueue, BlockingWait, NoStats>;
+
 #endif
@@ -0,0 +1,126 @@
+#ifndef _worker_local_
+#define _worker_local_
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+#include "thread-pool.h"
+
+using namespace std;
+
+// Una copia de T por worker del pool (estilo enumerable_thread_specific).
+// Cada copia se construye recien la primera vez que su worker llama local(),
+// y va en su propia linea de cache, asi que acumular ahi no necesita
+// atomicos ni hay false sharing. Al final combine() junta todo de una.
+// Los hilos que no son workers tambien tienen su copia, pero pasan por un lock.
+template <typename T, typename Pool = ThreadPool>
+class WorkerLocal
+{
+public:
+  WorkerLocal(Pool &pool, const function<T()> &init = []()
+                          { return T(); });
+
+  // La copia del hilo actual
+  T &local();
+
+  // Recorre las copias ya construidas. No llamarlo con tasks usandolas
+  void forEach(const function<void(T &)> &fn);
+
+  // Junta las copias con op (asociativa); sin copias devuelve init()
+  T combine(const function<T(const T &, const T &)> &op);
+
+  // Destruye todas las copias
+  void clear();
+
+private:
+  struct alignas(64) slot
+  {
+    optional<T> value;
+  };
+
+  Pool &pool;
+  function<T()> init;
+  vector<slot> slots; // una por worker
+
+  mutex externalLock; // pa' los hilos que no son del pool
+  map<thread::id, unique_ptr<slot>> external;
+
+  WorkerLocal(const WorkerLocal &original) = delete;
+  WorkerLocal &operator=(const WorkerLocal &rhs) = delete;
+};
+
+template <typename T, typename Pool>
+WorkerLocal<T, Pool>::WorkerLocal(Pool &pool, const function<T()> &init) : pool(pool),
+                                                                           init(init),
+                                                                           slots(pool.maxWorkers())
+{
+  if (!init)
+  {
+    throw invalid_argument("Cannot use null initializer in WorkerLocal");
+  }
+}
+
+template <typename T, typename Pool>
+T &WorkerLocal<T, Pool>::local()
+{
+  int id = pool.currentWorkerId();
+  if (id >= 0)
+  {
+    slot &s = slots[id];
+    if (!s.value)
+      s.value.emplace(init());
+    return *s.value;
+  }
+
+  lock_guard<mutex> lg(externalLock);
+  unique_ptr<slot> &s = external[this_thread::get_id()];
+  if (!s)
+    s = make_unique<slot>();
+  if (!s->value)
+    s->value.emplace(init());
+  return *s->value;
+}
+
+template <typename T, typename Pool>
+void WorkerLocal<T, Pool>::forEach(const function<void(T &)> &fn)
+{
+  for (auto &s : slots)
+    if (s.value)
+      fn(*s.value);
+
+  lock_guard<mutex> lg(externalLock);
+  for (auto &entry : external)
+    if (entry.second->value)
+      fn(*entry.second->value);
+}
+
+template <typename T, typename Pool>
+T WorkerLocal<T, Pool>::combine(const function<T(const T &, const T &)> &op)
+{
+  optional<T> result;
+  forEach([&](T &value)
+          {
+        if (result)
+            result.emplace(op(*result, value));
+        else
+            result.emplace(value); });
+  return result ? move(*result) : init();
+}
+
+template <typename T, typename Pool>
+void WorkerLocal<T, Pool>::clear()
+{
+  for (auto &s : slots)
+    s.value.reset();
+
+  lock_guard<mutex> lg(externalLock);
+  external.clear();
+}
+
+#endif